@@ -0,0 +1,90 @@
+// micro benchmark of the unrolled mat3/mat4 multiplications, the affine mat3 multiplication
+// and the mat3 -> mat4 promotion, against the generic matrix multiplication
+#define NITROGL_USE_STD_MATH
+
+#include <nitrogl/math.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace nitrogl;
+
+template<class kernel>
+void bench(const char * name, const kernel & run, int repeats=200) {
+    run(); // warm up
+    const auto start = std::chrono::steady_clock::now();
+    for (int ix = 0; ix < repeats; ++ix) run();
+    const auto end = std::chrono::steady_clock::now();
+    std::printf("%-26s %9.3f ns/op\n", name,
+                std::chrono::duration<double, std::nano>(end-start).count()/repeats/1024.0);
+}
+
+float random_float() { return float(std::rand()%2000 - 1000)/37.0f; }
+
+int main() {
+    const unsigned count = 1024;
+    std::vector<mat3f> a3(count), b3(count), c3(count);
+    std::vector<mat4f> a4(count), b4(count), c4(count);
+    for (unsigned ix = 0; ix < count; ++ix) {
+        // affine matrices, like the transforms of draws
+        a3[ix] = mat3f::rotation(random_float(), random_float(), random_float());
+        b3[ix] = mat3f::translate(random_float(), random_float());
+        b3[ix].pre_scale(vec2f(random_float(), random_float()));
+        a4[ix] = mat4f(a3[ix]); b4[ix] = mat4f(b3[ix]);
+    }
+    using base3 = matrix<float, 3, 3>;
+    using base4 = matrix<float, 4, 4>;
+    volatile float sink = 0.0f;
+
+    bench("mat3 generic", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix)
+            c3[ix] = base3::multiply<3, 3, 3, true, true>(a3[ix], b3[ix]);
+        sink = sink + c3[5][2]; });
+    bench("mat3 unrolled", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix)
+            c3[ix] = base3::multiply(a3[ix], b3[ix]);
+        sink = sink + c3[5][2]; });
+    bench("mat3 affine", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix)
+            mat3f::multiply_affine(a3[ix], b3[ix], c3[ix]);
+        sink = sink + c3[5][2]; });
+    bench("mat3 operator*", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix)
+            c3[ix] = a3[ix] * b3[ix];
+        sink = sink + c3[5][2]; });
+    bench("mat3 operator*=", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix) {
+            c3[ix] = a3[ix]; c3[ix] *= b3[ix];
+        }
+        sink = sink + c3[5][2]; });
+    bench("mat4 generic", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix)
+            c4[ix] = base4::multiply<4, 4, 4, true, true>(a4[ix], b4[ix]);
+        sink = sink + c4[5][2]; });
+    bench("mat4 unrolled", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix)
+            c4[ix] = base4::multiply(a4[ix], b4[ix]);
+        sink = sink + c4[5][2]; });
+    bench("mat4 operator*", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix)
+            c4[ix] = a4[ix] * b4[ix];
+        sink = sink + c4[5][2]; });
+    bench("mat4 operator*=", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix) {
+            c4[ix] = a4[ix]; c4[ix] *= b4[ix];
+        }
+        sink = sink + c4[5][2]; });
+    bench("mat3 -> mat4 (r,c) loop", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix) {
+            mat4f m; // the previous promotion, identity fill and (row, col) copies
+            for (unsigned r = 0; r < 3; ++r)
+                for (unsigned c = 0; c < 3; ++c) m(r, c) = a3[ix](r, c);
+            c4[ix] = m;
+        }
+        sink = sink + c4[5][2]; });
+    bench("mat3 -> mat4 promotion", [&]() {
+        for (unsigned ix = 0; ix < count; ++ix) c4[ix] = mat4f(a3[ix]);
+        sink = sink + c4[5][2]; });
+    return 0;
+}
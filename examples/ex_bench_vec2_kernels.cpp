@@ -0,0 +1,55 @@
+// micro benchmark of the vec2 kernels (bbox, indexed bbox, affine transform),
+// simd against scalar. build it with -mavx2 to bench the avx2 kernels.
+#define NITROGL_USE_STD_MATH
+
+#include <nitrogl/math.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace nitrogl;
+
+template<class kernel>
+void bench(const char * name, const kernel & run, int repeats=500) {
+    run(); // warm up
+    const auto start = std::chrono::steady_clock::now();
+    for (int ix = 0; ix < repeats; ++ix) run();
+    const auto end = std::chrono::steady_clock::now();
+    std::printf("%-22s %9.3f us\n", name,
+                std::chrono::duration<double, std::micro>(end-start).count()/repeats);
+}
+
+int main() {
+    const unsigned count = 1u<<16;
+    std::vector<vec2f> points(count), out(count);
+    std::vector<unsigned int> indices(count*3);
+    for (auto & p : points) p = { float(std::rand()%20000)/7.0f, float(std::rand()%20000)/3.0f };
+    for (auto & i : indices) i = unsigned(std::rand())%count;
+    mat3f matrix = mat3f::translate(3.5f, -2.25f);
+    matrix *= mat3f::rotation(0.3f);
+    volatile float sink = 0.0f;
+
+#if defined(NITROGL_SIMD_AVX2)
+    std::printf("kernels: avx2\n");
+#elif defined(NITROGL_SIMD_SSE2)
+    std::printf("kernels: sse2\n");
+#elif defined(NITROGL_SIMD_NEON)
+    std::printf("kernels: neon\n");
+#else
+    std::printf("kernels: scalar\n");
+#endif
+    std::printf("%u points, %u indices\n", count, unsigned(indices.size()));
+
+    bench("bbox scalar", [&]() { sink = sink + vec2_kernels::scalar::bbox(points.data(), count).right; });
+    bench("bbox", [&]() { sink = sink + vec2_kernels::bbox(points.data(), count).right; });
+    bench("indexed bbox scalar", [&]() {
+        sink = sink + vec2_kernels::scalar::bbox(points.data(), indices.data(), indices.size()).right; });
+    bench("indexed bbox", [&]() {
+        sink = sink + vec2_kernels::bbox(points.data(), indices.data(), indices.size()).right; });
+    bench("transform scalar", [&]() {
+        vec2_kernels::scalar::transform(matrix, points.data(), out.data(), count); sink = sink + out[7].x; });
+    bench("transform", [&]() {
+        vec2_kernels::transform(matrix, points.data(), out.data(), count); sink = sink + out[7].x; });
+    return 0;
+}
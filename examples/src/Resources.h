@@ -10,6 +10,7 @@
 #include "../libs/rapidxml/rapidxml.hpp"
 #include <nitrogl/ogl/gl_texture.h>
 #include <nitrogl/text/bitmap_font.h>
+#include <nitrogl/text/sdf_font.h>
 
 using std::cout;
 using std::endl;
@@ -138,19 +139,8 @@ public:
         doc.parse<0>(loadTextFile(file_name));
     }
 
-    template<int max_chars=128>
-    static nitrogl::text::bitmap_font<max_chars> loadFont(const std::string & font_folder,
-                                                          bool pre_mul_alpha=true,
-                                                          bool flip_vertically=false,
-                                                          char r=8, char g=8, char b=8, char a=8,
-                                                          bool is_unpacked=true) {
-        std::string font_path = font_folder + "/font.fnt";
-        std::string bitmap_path = font_folder + "/font.png";
-        nitrogl::text::bitmap_font<max_chars> font(loadTexture(bitmap_path.data(),
-                                                               pre_mul_alpha, flip_vertically,
-                                                               r, g, b, a, is_unpacked));
-        rapidxml::xml_document<> d;
-        loadXML(font_path.data(), d);
+    template<class font_type>
+    static void loadFontMetrics(font_type & font, rapidxml::xml_document<> & d) {
         auto * f= d.first_node("font");
         auto * f_info= f->first_node("info");
         auto * f_common= f->first_node("common");
@@ -175,7 +165,52 @@ public:
             font.addChar(id, x, y, w, h, xoffset, yoffset, xadvance);
             iter = iter->next_sibling();
         } while (iter);
+    }
+
+    template<int max_chars=128>
+    static nitrogl::text::bitmap_font<max_chars> loadFont(const std::string & font_folder,
+                                                          bool pre_mul_alpha=true,
+                                                          bool flip_vertically=false,
+                                                          char r=8, char g=8, char b=8, char a=8,
+                                                          bool is_unpacked=true) {
+        std::string font_path = font_folder + "/font.fnt";
+        std::string bitmap_path = font_folder + "/font.png";
+        nitrogl::text::bitmap_font<max_chars> font(loadTexture(bitmap_path.data(),
+                                                               pre_mul_alpha, flip_vertically,
+                                                               r, g, b, a, is_unpacked));
+        rapidxml::xml_document<> d;
+        loadXML(font_path.data(), d);
+        loadFontMetrics(font, d);
+        return font;
+    }
 
+    /**
+     * load a distance field font, that was generated into the BMFont xml format
+     * (msdf-bmfont-xml, msdf-atlas-gen), with an optional
+     * <distanceField fieldType="msdf|sdf" distanceRange="4"/> node
+     */
+    template<int max_chars=128>
+    static nitrogl::text::sdf_font<max_chars> loadSDFFont(const std::string & font_folder,
+                                                          bool flip_vertically=false) {
+        std::string font_path = font_folder + "/font.fnt";
+        std::string bitmap_path = font_folder + "/font.png";
+        auto img = loadImageFromCompressedPath(bitmap_path.data(), false, flip_vertically);
+        // distances are not colors, do not pre-multiply and do not mip-map
+        nitrogl::text::sdf_font<max_chars> font(nitrogl::gl_texture::from_unpacked_image(
+                img.width, img.height, img.data, 8, img.channels>1?8:0, img.channels>2?8:0,
+                img.channels==4?8:0, false, 1, GL_LINEAR, GL_LINEAR));
+        delete img.data;
+        rapidxml::xml_document<> d;
+        loadXML(font_path.data(), d);
+        loadFontMetrics(font, d);
+        auto * f_field = d.first_node("font")->first_node("distanceField");
+        if(f_field) {
+            auto * type = f_field->first_attribute("fieldType");
+            auto * range = f_field->first_attribute("distanceRange");
+            if(type) font.multiChannel = strncmp(type->value(), "sdf", 3)!=0;
+            if(range) font.distanceRange = float(atof(range->value()));
+        }
+        if(img.channels<3) font.multiChannel = false;
         return font;
     }
 
@@ -24,6 +24,8 @@ namespace nitrogl {
 #if __VERSION__>=130
 
 #define TEXTURE_2D texture
+#define TEXTURE_2D_ARRAY texture
+#define TEXTURE_2D_LOD textureLod
 #define ATTRIBUTE in
 #define SHADER_IN in
 #define SHADER_OUT out
@@ -32,6 +34,9 @@ namespace nitrogl {
 #else
 
 #define TEXTURE_2D texture2D
+#define TEXTURE_2D_ARRAY texture2DArray
+// explicit lod is not available in old fragment shaders, fallback to automatic lod
+#define TEXTURE_2D_LOD(s, uv, lod) texture2D(s, uv)
 #define ATTRIBUTE attribute
 #define SHADER_IN varying
 #define SHADER_OUT varying
@@ -47,33 +52,57 @@ uniform mat4 mat_view;
 uniform mat4 mat_proj;
 uniform mat3 mat_transform_uvs;
 uniform vec4 bbox;
-uniform bool has_missing_uvs;
-uniform bool has_missing_q;
 
 // ATTRIBUTE = in vertex attributes
 ATTRIBUTE vec2 VS_pos; // position of vertex
-ATTRIBUTE vec2 VS_uvs_sampler; // uv of vertex, extras will be taken from (0, 0, 0, 1) if vbo input is smaller
-ATTRIBUTE float VS_q_sampler; // q of vertex, good for projections
+ATTRIBUTE vec2 VS_uvs_sampler; // uv of vertex, not read by the generated uvs variant
+ATTRIBUTE float VS_q_sampler; // q of vertex, good for projections. constant 1 when missing
 
 // SHADER_OUT = out/varying
 SHADER_OUT vec3 PS_uvs_sampler;
 
+#ifdef __BATCHED
+// per draw data of batches, 7 texels per draw:
+// model columns (the w of the first is the opacity), uvs transform columns, bbox
+uniform samplerBuffer draws;
+ATTRIBUTE float VS_draw_id;
+SHADER_OUT float PS_opacity;
+#endif
+
 void main()
 {
-    // Uniform Branching in vertex shader is OK, not a bottleneck
-    float q = has_missing_q ? 1.0 : VS_q_sampler;
-    // missing uv
-    vec2 uv_missing = (VS_pos - bbox.xy)/bbox.zw;
-    uv_missing.y = 1.0 - uv_missing.y;
-    // final uv
-    vec2 uv = has_missing_uvs ? uv_missing : VS_uvs_sampler;
-    PS_uvs_sampler = vec3((mat_transform_uvs * vec3(uv, 1.0)).st, q);
+#ifdef __BATCHED
+    int base = int(VS_draw_id)*7;
+    vec4 model_0 = texelFetch(draws, base);
+    mat3 model = mat3(model_0.xyz, texelFetch(draws, base+1).xyz, texelFetch(draws, base+2).xyz);
+    mat3 transform_uvs = mat3(texelFetch(draws, base+3).xyz, texelFetch(draws, base+4).xyz,
+                              texelFetch(draws, base+5).xyz);
+    vec4 box = texelFetch(draws, base+6);
+    PS_opacity = model_0.w;
+#else
+    mat3 transform_uvs = mat_transform_uvs;
+    vec4 box = bbox;
+#endif
+#ifdef __GENERATED_UVS
+    // uvs are generated from the bounding box
+    vec2 uv = (VS_pos - box.xy)/box.zw;
+    uv.y = 1.0 - uv.y;
+#else
+    vec2 uv = VS_uvs_sampler;
+#endif
+    PS_uvs_sampler = vec3((transform_uvs * vec3(uv, 1.0)).st, VS_q_sampler);
+#ifdef __BATCHED
+    gl_Position = mat_proj * mat_view * vec4(model * vec3(VS_pos, 1.0), 1.0);
+#else
     gl_Position = mat_proj * mat_view * mat_model * vec4(VS_pos, 1.0, 1.0);
+#endif
 }
 
 )foo";
 
 
+        constexpr static const char * const define_generated_uvs = "#define __GENERATED_UVS\n";
+        constexpr static const char * const define_batched = "#define __BATCHED\n";
         constexpr static const char * const define_sampler = "#define __SAMPLER_MAIN sampler_";
         constexpr static const char * const define_premul_alpha = "\n#define __PRE_MUL_ALPHA\n";
 
@@ -88,6 +117,9 @@ uniform struct DATA_MAIN {
 
 // in
 SHADER_IN vec3 PS_uvs_sampler;
+#ifdef __BATCHED
+SHADER_IN float PS_opacity;
+#endif
 
 // out
 #if __VERSION__>=130
@@ -127,13 +159,16 @@ void main()
     vec4 bd_texel = TEXTURE_2D(data_main.texture_backdrop, bd_uvs);
     // un mul alpha if backdrop is alpha-mul
 #ifdef __PRE_MUL_ALPHA
-    bd_texel.rgb /= bd_texel.a;
+    if(bd_texel.a>0.0) bd_texel.rgb /= bd_texel.a;
 #endif
 
     // sample from un-multiplied-alpha sampler, also, perspective correct the uvs with q coord
     vec4 sampler_out = __SAMPLER_MAIN(PS_uvs_sampler/PS_uvs_sampler.z);
     // apply opacity
     sampler_out.a *= data_main.opacity;
+#ifdef __BATCHED
+    sampler_out.a *= PS_opacity;
+#endif
     // blend mode with un-multiplied-alpha backdrop
     vec3 blended_colors_only = __BLEND(sampler_out.rgb, bd_texel.rgb);
     vec4 blended_colors_final = __blend_in_place(sampler_out, bd_texel, blended_colors_only);
@@ -142,7 +177,7 @@ void main()
     glFragColor = composited;
 
 #ifndef __PRE_MUL_ALPHA
-    glFragColor.rgb /= glFragColor.a;
+    if(glFragColor.a>0.0) glFragColor.rgb /= glFragColor.a;
 #endif
 }
 )foo";
@@ -150,19 +185,23 @@ void main()
     public:
 
         struct VAS {
-            shader_program::shader_vertex_attr_t data[3];
-            static constexpr unsigned size() { return 3; }
+            shader_program::shader_vertex_attr_t data[4];
+            static constexpr unsigned size() { return 4; }
         };
 
         // I have to have this uniform location cache. It is different
         // from shader to shader instance, so I have no way around saving it.
         struct uniforms_type {
             GLint mat_model=-1, mat_view=-1, mat_proj=-1, mat_transform_uvs=-1,
-            bbox=-1, has_missing_uvs=-1, has_missing_q=-1,
+            bbox=-1, draws=-1,
             opacity=-1, time=-1, tex_backdrop=-1, window_size=-1;
         };
 
         uniforms_type uniforms;
+        // the vertex shader variant, that generates uvs from the bbox
+        bool generated_uvs=false;
+        // the vertex shader variant, that reads per draw data of batches, see batch_render_node
+        bool batched=false;
 
         const uniforms_type & uniforms_locations() const {
             return uniforms;
@@ -179,6 +218,8 @@ void main()
                   shader_program::shader_attribute_component_type::Float},
                 {"VS_q_sampler", 2,
                    shader_program::shader_attribute_component_type::Float},
+                {"VS_draw_id", 3,
+                   shader_program::shader_attribute_component_type::Float},
             }};
             return vas;
         }
@@ -200,11 +241,12 @@ void main()
             resolve_vertex_attributes_and_uniforms_and_link();
         }
         main_shader_program(const main_shader_program & o) = default;
-        main_shader_program(main_shader_program && o) noexcept : shader_program(nitrogl::traits::move(o)), uniforms(o.uniforms) {}
+        main_shader_program(main_shader_program && o) noexcept : shader_program(nitrogl::traits::move(o)),
+                        uniforms(o.uniforms), generated_uvs(o.generated_uvs), batched(o.batched) {}
         main_shader_program & operator=(const main_shader_program & o) = default;
         main_shader_program & operator=(main_shader_program && o)  noexcept {
             shader_program::operator=(nitrogl::traits::move(o));
-            uniforms=o.uniforms;return *this;
+            uniforms=o.uniforms; generated_uvs=o.generated_uvs; batched=o.batched; return *this;
         }
 
         ~main_shader_program() = default;
@@ -219,9 +261,8 @@ void main()
             uniforms.mat_view = uniformLocationByName("mat_view");
             uniforms.mat_proj = uniformLocationByName("mat_proj");
             uniforms.mat_transform_uvs = uniformLocationByName("mat_transform_uvs");
-            uniforms.has_missing_uvs = uniformLocationByName("has_missing_uvs");
-            uniforms.has_missing_q = uniformLocationByName("has_missing_q");
             uniforms.bbox = uniformLocationByName("bbox");
+            uniforms.draws = uniformLocationByName("draws");
 
             uniforms.opacity = uniformLocationByName("data_main.opacity");
             uniforms.time = uniformLocationByName("data_main.time");
@@ -240,10 +281,13 @@ void main()
         {  glUniformMatrix3fv(uniforms.mat_transform_uvs, 1, GL_FALSE, matrix.data()); glCheckError(); }
         void updateBBox(float left, float top, float right, float bottom) const
         {  glUniform4f(uniforms.bbox, left, top, right-left, bottom-top); glCheckError(); }
-        void update_has_missing_uvs(bool value) const
-        {  glUniform1i(uniforms.has_missing_uvs, value); glCheckError(); }
-        void update_has_missing_qs(bool value) const
-        {  glUniform1i(uniforms.has_missing_q, value); glCheckError(); }
+        // texture unit of the per draw data buffer of batches
+        void updateDrawsBuffer(GLint unit) const
+        {  glUniform1i(uniforms.draws, unit); glCheckError(); }
+        // constant q for draws, that disable the q attribute array. this is context state,
+        // and not part of a VAO
+        static void updateConstantQ(GLfloat q)
+        { glVertexAttrib1f(GLuint(shader_vertex_attributes().data[2].location), q); glCheckError(); }
         void updateOpacity(GLfloat opacity) const
         { glUniform1f(uniforms.opacity, opacity); glCheckError(); }
         void update_time(GLuint value) const
@@ -33,6 +33,37 @@ namespace nitrogl {
     #endif
 #endif
 
+// half float vertex attributes (gl>=3.0, gl-es>=3.0), gl-es-2 only has them as an extension
+#ifndef NITROGL_SUPPORTS_HALF_FLOAT_VERTICES
+    #if (NITROGL_OPENGL_MAJOR_VERSION>=3)
+        #define NITROGL_SUPPORTS_HALF_FLOAT_VERTICES
+    #endif
+#endif
+
+// texture buffers and base vertex draws (gl>=3.2, gl-es>=3.2) and VAO, required by the batch render node
+#ifndef NITROGL_SUPPORTS_BATCHING
+    #if defined(NITROGL_SUPPORTS_VAO) && ((NITROGL_OPENGL_MAJOR_VERSION>3) || \
+        (NITROGL_OPENGL_MAJOR_VERSION==3 && NITROGL_OPENGL_MINOR_VERSION>=2))
+        #define NITROGL_SUPPORTS_BATCHING
+    #endif
+#endif
+
+// multi draw indirect with base instance (gl>=4.3), gl-es has no multi draws
+#ifndef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+    #if !defined(NITROGL_OPEN_GL_ES) && ((NITROGL_OPENGL_MAJOR_VERSION>4) || \
+        (NITROGL_OPENGL_MAJOR_VERSION==4 && NITROGL_OPENGL_MINOR_VERSION>=3))
+        #define NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+    #endif
+#endif
+
+// fence sync objects (gl>=3.2, gl-es>=3.0), required by the rotating frame targets of the canvas
+#ifndef NITROGL_SUPPORTS_FENCE_SYNC
+    #if (NITROGL_OPENGL_MAJOR_VERSION>3) || (NITROGL_OPENGL_MAJOR_VERSION==3 && \
+        (defined(NITROGL_OPEN_GL_ES) || NITROGL_OPENGL_MINOR_VERSION>=2))
+        #define NITROGL_SUPPORTS_FENCE_SYNC
+    #endif
+#endif
+
 #ifndef NITROGL_OPENGL_GLSL_VERSION
     #ifdef NITROGL_OPEN_GL_ES
         #if (NITROGL_OPENGL_MAJOR_VERSION==2)
@@ -14,7 +14,14 @@
 #include "../compositing/porter_duff.h"
 #include "../_internal/main_shader_program.h"
 #include "../_internal/string_utils.h"
+#include "../_internal/lru_pool.h"
+#include "../traits.h"
 #include "../samplers/sampler.h"
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
 
 namespace nitrogl {
 
@@ -31,109 +38,136 @@ namespace nitrogl {
         }
 
         /**
-         * sources buffer to pointer for stitching pre defined strings, also
-         * includes optional storage for char arrays
-         * @tparam N size of sources pointers array
-         * @tparam M size of optional storage
+         * Growable sources arena of pointers to const char arrays and their lengths, that
+         * are stitched together into a shader source. Memory grows geometrically and is never
+         * released between compositions, so hot compositions do not allocate at all.
+         * @tparam Allocator allocator for the pointers and lengths arrays
          */
-        template<unsigned N, unsigned M=1>
-        struct sources_buffer {
-            static constexpr const GLchar * const comma_and_new_line = ";\n";
+        template<class Allocator=nitrogl::std_rebind_allocator<>>
+        struct sources_arena {
+            using ptr_allocator_t = typename Allocator::template rebind<const char *>::other;
+            using len_allocator_t = typename Allocator::template rebind<GLint>::other;
             static constexpr const GLchar * const comma_and_2_new_line = ";\n\n";
-            static constexpr const GLchar * comma = ";";
-            static constexpr const GLchar * lcp = "{";
-            static constexpr const GLchar * rcp = "}";
-            static constexpr const GLchar * char_comma = ";";
-            static constexpr const GLchar * char_space = " ";
             static constexpr const GLchar * char_under_score = "_";
-            static constexpr const GLchar * char_null_term = "\0";
             static constexpr const GLchar * char_new_line = "\n";
-            const char * sources[N]; // array with pointers to const chars
-            int lengths[N];
-            char extra_storage[M]; // writable area
-            const char* * head_sources; // pointer to array with pointers to const chars
-            char * head_storage;
-            int * head_lengths;
+            const char * * sources; // array with pointers to const chars
+            GLint * lengths;
+            unsigned _size, _capacity;
+            ptr_allocator_t _ptr_allocator;
+            len_allocator_t _len_allocator;
 
-            sources_buffer() : head_sources(sources), head_storage(extra_storage),
-                            head_lengths(lengths), sources{nullptr}, lengths{0},
-                            extra_storage{0} {
+            explicit sources_arena(unsigned initial_capacity=256,
+                                   const Allocator & allocator=Allocator()) :
+                        sources(nullptr), lengths(nullptr), _size(0), _capacity(0),
+                        _ptr_allocator(allocator), _len_allocator(allocator) {
+                reserve(initial_capacity);
+            }
+            sources_arena(const sources_arena &)=delete;
+            sources_arena & operator=(const sources_arena &)=delete;
+            ~sources_arena() {
+                if(sources) _ptr_allocator.deallocate(sources, _capacity);
+                if(lengths) _len_allocator.deallocate(lengths, _capacity);
             }
 
-            void reset() { head_sources=sources; head_storage=extra_storage; head_lengths=lengths; }
-            unsigned size() const { return head_sources-sources; }
-            unsigned len_sources() const { return head_sources-sources; }
-            unsigned len_lengths() const { return head_lengths-lengths; }
-            unsigned len_storage() const { return head_storage-extra_storage; }
-            struct write_storage_info_t { char * ptr; int len; };
+            void reserve(unsigned new_capacity) {
+                if(new_capacity<=_capacity) return;
+                auto * new_sources = _ptr_allocator.allocate(new_capacity);
+                auto * new_lengths = _len_allocator.allocate(new_capacity);
+                for (unsigned ix = 0; ix < _size; ++ix) {
+                    new_sources[ix]=sources[ix]; new_lengths[ix]=lengths[ix];
+                }
+                if(sources) _ptr_allocator.deallocate(sources, _capacity);
+                if(lengths) _len_allocator.deallocate(lengths, _capacity);
+                sources=new_sources; lengths=new_lengths; _capacity=new_capacity;
+            }
+            void reset() { _size=0; }
+            unsigned size() const { return _size; }
+            unsigned capacity() const { return _capacity; }
 
             void write_char_array_pointer(const char * arr, int len=-1) {
                 // write a pointer(a bit dangerous), len=-1 means it is null-terminated
-                *(head_sources++)=arr;
-                *(head_lengths++)=len;
+                if(_size==_capacity) reserve(_capacity ? _capacity<<1 : 64);
+                sources[_size]=arr; lengths[_size]=len; ++_size;
             }
             void write_range_pointer(const char * begin, const char * end) {
-                // write a pointer(a bit dangerous), len=-1 means it is null-terminated
-                *(head_sources++)=begin;
-                *(head_lengths++)=end-begin;
-            }
-
-            write_storage_info_t write_int(int v) {
-                // converts int to char array in storage and then copies the pointer
-                *(head_sources++)=head_storage;
-                unsigned len = nitrogl::facebook_uint32_to_str(v, head_storage);
-                head_storage+=len;
-                *(head_lengths++)=len;
-                return { head_storage-len, int(len) };
-            }
-            write_storage_info_t write_int_to_storage(int v) {
-                // converts int to char array in storage and then copies the pointer
-                unsigned len = nitrogl::facebook_uint32_to_str(v, head_storage);
-                head_storage+=len;
-                return { head_storage-len, int(len) };
-            }
-            write_storage_info_t write_char_array_to_storage(char * arr) {
-                // copy null-terminated array into storage and then write to sources
-                unsigned ix = 0;
-                const auto available = N-len_storage();
-                for (; (ix < available) && *arr; ++ix, *(head_storage++)=*(arr++)) {
-                }
-                write_char_array_pointer(head_storage-ix, ix);
-                return {head_storage-ix, ix};
-            }
-            write_storage_info_t write_range_to_storage(const char * begin, const char * end) {
-                // range does not contain null-term
-                unsigned ix = 0;
-                const auto available = N-len_storage();
-                for (; (ix < available) && begin<end; ++ix, *(head_storage++)=*(begin++)) {
-                }
-                write_char_array_pointer(head_storage-ix, ix);
-                return {head_storage-ix, ix};
+                write_char_array_pointer(begin, int(end-begin));
             }
-            write_storage_info_t write_char_to_storage_and_buffers(char v) {
-                *(head_storage++) = v;
-                *(head_sources++) = head_storage-1;
-                *(lengths++) = 1;
-                return { head_storage-1, 1 };
-            }
-
-            void write_null_terminate() { write_char_array_pointer(char_null_term, 1); }
-            void write_comma() { write_char_array_pointer(char_comma, 1); }
             void write_new_line() { write_char_array_pointer(char_new_line, 1); }
-            void write_space() { write_char_array_pointer(char_space, 1); }
             void write_under_score() { write_char_array_pointer(char_under_score, 1); }
-            void write_lcp() { write_char_array_pointer(lcp, 1); }
-            void write_rcp() { write_char_array_pointer(rcp, 1); }
-            void write_comma_and_newline() { write_char_array_pointer(comma_and_new_line, 2); }
             void write_comma_and_2_newline() { write_char_array_pointer(comma_and_2_new_line, 3); }
         };
 
+        /**
+         * A pre-parsed sampler main() source. We scan a main() string only once for the
+         * 'sampler_{local_id}' and 'data.' tokens and record them with their offsets, so
+         * later compositions just stitch ranges, which is linear in the output size.
+         */
+        struct main_template {
+            enum class token_kind { sampler, data };
+            struct token_t {
+                const char * begin; // begin of token in main source
+                const char * end; // end of token in main source, composition resumes here
+                token_kind kind;
+                int local_id; // local id of sub-sampler, only for sampler tokens
+            };
+            using token_allocator_t = nitrogl::std_rebind_allocator<token_t>;
+
+            const char * source=nullptr; // main() pointer that was parsed
+            const char * begin=nullptr; // main() after leading new lines
+            dynamic_array<token_t, token_allocator_t> tokens{token_allocator_t()};
+
+            void parse(const char * main) {
+                tokens.clear();
+                source=main;
+                begin=nitrogl::find_first_not_of_in(main, '\n', -1);
+                if(begin==nullptr) return;
+                for (const char * it = begin; *it; ) {
+                    if(nitrogl::is_equal("sampler_", it, 8)) {
+                        // sampler_{local_id}( --> token spans [sampler_, '(')
+                        const auto * id_begin = it + 8;
+                        const auto * paren = nitrogl::index_of_in("(", id_begin, 1);
+                        if(paren==nullptr) break;
+                        tokens.push_back({it, paren, token_kind::sampler,
+                                          nitrogl::s2i(id_begin, int(paren-id_begin))});
+                        it = paren;
+                    } else if(nitrogl::is_equal("data.", it, 5)) {
+                        // data. --> token spans [data, .)
+                        tokens.push_back({it, it + 4, token_kind::data, -1});
+                        it += 4;
+                    } else ++it;
+                }
+            }
+        };
+
         template<class number> static number min(number a, number b) { return a<b?a:b;}
         template<class number> static number max(number a, number b) { return a<b?b:a;}
 
     private:
-        template<unsigned N, unsigned M>
-        static void _internal_composite(sampler_t * sampler, sources_buffer<N, M> & buffer) {
+        using arena_type = sources_arena<>;
+        // per-thread caches, so they use the heap rather than the shared static storage
+        using templates_alloc = nitrogl::std_rebind_allocator<>;
+        using lru_main_template_pool_t = microc::lru_pool<main_template, 6,
+                                                nitrogl::uintptr_type, templates_alloc>;
+
+        static arena_type & arena() {
+            // growable arena, one per thread, its memory is reused between compositions
+            static thread_local arena_type arena_{};
+            return arena_;
+        }
+
+        static const main_template & main_template_of(const char * main) {
+            // parsed templates are keyed by the main() pointer, which is stable for
+            // each distinct main() string (samplers hash by it as well).
+            static thread_local lru_main_template_pool_t pool{0.5f, templates_alloc()};
+            if(!pool.are_items_constructed())
+                pool.construct();
+            auto res = pool.get(reinterpret_cast<nitrogl::uintptr_type>(main));
+            if(!res.is_active || res.object.source!=main)
+                res.object.parse(main);
+            return res.object;
+        }
+
+        static void _internal_composite(sampler_t * sampler, arena_type & buffer) {
             // if the sampler is nullptr or was already visited, then we don't need to write it
             if(sampler==nullptr || sampler->traversal_info().visited) return;
             // otherwise, recurse bottom-up
@@ -142,122 +176,68 @@ namespace nitrogl {
                 _internal_composite(sampler->sub_sampler(ix), buffer);
 
             sampler->traversal_info().visited=true;
+            const auto & info = sampler->traversal_info();
 
             // uniform struct DATA_ID { float a;  vec2 b; } data_ID;
             const bool has_uniforms_data = !nitrogl::is_empty(sampler->uniforms());
             if(has_uniforms_data) {
                 buffer.write_char_array_pointer("uniform struct DATA_", -1);
-                buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
-                                                sampler->traversal_info().size_id_str()); // ID from previous stored value
+                buffer.write_char_array_pointer(info.id_str(), info.size_id_str()); // ID from previous stored value
                 buffer.write_char_array_pointer(sampler->uniforms(), -1);
                 buffer.write_char_array_pointer("data_", -1);
-                buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
-                                                sampler->traversal_info().size_id_str()); // ID from previous stored value
+                buffer.write_char_array_pointer(info.id_str(), info.size_id_str()); // ID from previous stored value
                 buffer.write_comma_and_2_newline();
             }
 
             // vec4 sampler_ID
             buffer.write_char_array_pointer("vec4 sampler_", -1);
-            buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
-                                            sampler->traversal_info().size_id_str());
+            buffer.write_char_array_pointer(info.id_str(), info.size_id_str());
 
-            // now the tough part starts function body of sampler. Our goal
-            // is to track 'data.' and 'sampler_' strings and to stitch:
-            // data. --> data_{SAMPLER_ID}
-            // sampler_ --> data_{SAMPLER_ID}
-            // strategy is to make them race for the next one
-            const auto * main = nitrogl::find_first_not_of_in(sampler->main(), '\n', -1);
-            const auto handle = [&](race_t & race, const char * from) -> const char * {
-                race.handled=true;
-                switch (race.id) {
-                    case 0: { // sampler_{sub_sampler_local_id} -> sampler_{sub_sampler_global_id}
-                        auto begin_0 = from; // latest end loose
-                        auto end_0 = race.next + race.name_len; // end of sampler_
-                        buffer.write_range_pointer(begin_0, end_0); // stitch [main, sampler_)
-                        // parse local_id
-                        auto begin_1 = nitrogl::index_of_in("(", end_0, 1); // ptr to (
-                        auto local_id = nitrogl::s2i(end_0, begin_1-end_0); // local_id to int
-                        // stitch {global_id}
-                        buffer.write_char_array_pointer(sampler->sub_sampler(local_id)->traversal_info().id_str(),
-                                                        sampler->sub_sampler(local_id)->traversal_info().size_id_str());
-                        race.handled=true;
-                        return begin_1;
+            // function body of sampler. The tokens were found once, when the main()
+            // string was parsed, now we only stitch:
+            // data. --> data_{SAMPLER_ID}.
+            // sampler_{local_id} --> sampler_{SAMPLER_GLOBAL_ID}
+            const auto & tmpl = main_template_of(sampler->main());
+            const auto * latest_main = tmpl.begin;
+            if(latest_main==nullptr) return;
+            const auto tokens_count = tmpl.tokens.size();
+            for (unsigned ix = 0; ix < tokens_count; ++ix) {
+                const auto & token = tmpl.tokens[ix];
+                switch (token.kind) {
+                    case main_template::token_kind::sampler: {
+                        // sampler_{sub_sampler_local_id} -> sampler_{sub_sampler_global_id}
+                        if(sub_samplers_count==0) continue;
+                        buffer.write_range_pointer(latest_main, token.begin + 8); // stitch [main, sampler_)
+                        const auto & sub_info = sampler->sub_sampler(token.local_id)->traversal_info();
+                        buffer.write_char_array_pointer(sub_info.id_str(), sub_info.size_id_str());
+                        break;
                     }
-                    case 1: { // data. --> data_{current_sampler_global_id}.
-                        auto begin_0 = from; // latest end loose
-                        auto end_0 = race.next + race.name_len - 1; // end of '...data'
-                        buffer.write_range_pointer(begin_0, end_0); // stitch [main, data)
-                        //
+                    case main_template::token_kind::data: {
+                        // data. --> data_{current_sampler_global_id}.
+                        if(!has_uniforms_data) continue;
+                        buffer.write_range_pointer(latest_main, token.end); // stitch [main, data)
                         buffer.write_under_score(); // stitch _
-                        // stitch {current_sampler_id}
-                        buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
-                                                        sampler->traversal_info().size_id_str());
-                        race.handled=true;
-                        return end_0;
-                    }
-                }
-                return nullptr;
-            };
-            race_t races[2] = {
-                    {0, "sampler_", 8, main, true, true},
-                    {1, "data.", 5, main, true, true},
-            };
-            const auto * latest_main = main;
-            if(sub_samplers_count==0) races[0].enabled=false; // disable 0
-            if(!has_uniforms_data) races[1].enabled=false; // disable 1
-            int arg_min=0;
-            for(; arg_min!=-1; ) {
-                arg_min=-1;
-                // pick next index of handled and argmin
-                for (int ix = 0; ix < 2; ++ix) {
-                    auto & race = races[ix];
-                    if(!race.enabled) continue;
-                    if(race.handled) {
-                        race.next = index_of_in(race.name, latest_main, race.name_len);
-                        if(race.next==nullptr) { // did not find
-                            // let's disable it entirely
-                            race.enabled=false;
-                            continue;
-                        }
-                        // flag it is pending a handle
-                        race.handled=false;
+                        buffer.write_char_array_pointer(info.id_str(), info.size_id_str());
+                        break;
                     }
                 }
-                for (int ix = 0; ix < 2; ++ix) {
-                    auto & race = races[ix];
-                    if(!race.enabled) continue;
-                    if(!race.handled) {
-                        if(arg_min==-1 ||
-                            races[arg_min].next==nullptr ||
-                            race.next<races[arg_min].next)
-                            arg_min=ix;
-                    }
-                }
-                if(arg_min!=-1)
-                    latest_main=handle(races[arg_min], latest_main);
+                latest_main = token.end;
             }
             buffer.write_char_array_pointer(latest_main, -1); // stitch [latest_main, end)
             buffer.write_new_line(); // stitch [latest_main, end)
         }
 
-        struct race_t {
-            int id; // this dictates behaviour
-            const char * name; int name_len;
-            const char * next;
-            bool handled;
-            bool enabled;
-        };
-
     public:
         static bool composite_main_program_from_sampler(main_shader_program & program,
                                                         sampler_t & sampler,
                                                         const GLchar * glsl_version=nullptr,
                                                         bool is_premul_alpha_result=true,
                                                         const nitrogl::blend_mode_t blend_mode=nullptr,
-                                                        const nitrogl::compositor_t compositor=nullptr) {
+                                                        const nitrogl::compositor_t compositor=nullptr,
+                                                        bool generated_uvs=false,
+                                                        bool batched=false) {
             // fragment shards
-            using buffers_type = sources_buffer<1000, 1>;
-            static buffers_type buffers{};
+            auto & buffers = arena();
             buffers.reset();
             // write version
             const GLchar * glsl_v = glsl_version ? glsl_version : main_shader_program::glsl_version;
@@ -265,6 +245,7 @@ namespace nitrogl {
             buffers.write_new_line();
             // write compatability
             buffers.write_char_array_pointer(main_shader_program::shader_compat);
+            if(batched) buffers.write_char_array_pointer(main_shader_program::define_batched);
             // write frag variables
             buffers.write_char_array_pointer(main_shader_program::frag_other);
             buffers.write_char_array_pointer(nitrogl::porter_duff::base());
@@ -287,13 +268,20 @@ namespace nitrogl {
             auto & vertex = program.vertex();
             auto & fragment = program.fragment();
 
-            // vertex shader is always the same/constant here, so we can save a compilation once it is hot
-            // or was used compiled once in the past.
-            if(!vertex.isCompiled()) {
-                const GLchar * vertex_shader_sources[3] =
+            // vertex shader is one of four variants (uvs attribute or generated uvs, single or
+            // batched draws), so we can save a compilation once it is hot or the same variant
+            // was compiled once in the past.
+            if(!vertex.isCompiled() || program.generated_uvs!=generated_uvs ||
+                    program.batched!=batched) {
+                const GLchar * vertex_shader_sources[5] =
                         { main_shader_program::glsl_version, main_shader_program::shader_compat,
-                          main_shader_program::vert };
-                vertex.updateShaderSource(vertex_shader_sources, 3, nullptr, true);
+                          main_shader_program::define_generated_uvs,
+                          main_shader_program::define_batched, main_shader_program::vert };
+                if(!generated_uvs) vertex_shader_sources[2] = "";
+                if(!batched) vertex_shader_sources[3] = "";
+                vertex.updateShaderSource(vertex_shader_sources, 5, nullptr, true);
+                program.generated_uvs = generated_uvs;
+                program.batched = batched;
             }
             bool stat_compile = fragment.updateShaderSource(buffers.sources, buffers.size(),
                                                             buffers.lengths, true);
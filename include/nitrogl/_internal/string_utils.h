@@ -100,6 +100,30 @@ namespace nitrogl {
         return length;
     }
 
+    /**
+     * copy a null-terminated char array into dst, while replacing every occurrence of
+     * token with the decimal value. Output is truncated to fit dst_size (including the
+     * null termination). Useful for specializing GLSL templates with compile-time constants.
+     * @return dst
+     */
+    inline const char * specialize_int_into(char * dst, int dst_size, const char * src,
+                                            const char * token, uint32_t value) {
+        char value_str[12];
+        const auto value_len = int(facebook_uint32_to_str(value, value_str));
+        int token_len = 0;
+        for (; token[token_len]; ++token_len) {}
+        int len = 0;
+        while(*src && len < dst_size-1) {
+            if(token_len && is_equal(token, src, token_len)) {
+                for (int ix = 0; ix < value_len && len < dst_size-1; ++ix)
+                    dst[len++] = value_str[ix];
+                src += token_len;
+            } else dst[len++] = *(src++);
+        }
+        dst[len] = '\0';
+        return dst;
+    }
+
     class numbers_99_db {
         static const char * db() {
             return "0001020304050607080910111213141516171819"
@@ -48,12 +48,15 @@
 
 // text
 #include "text/bitmap_font.h"
+#include "text/sdf_font.h"
 #include "text/bitmap_glyph.h"
 #include "text/text_format.h"
 
 // ogl
 #include "ogl/gl_texture.h"
 #include "ogl/fbo.h"
+#include "ogl/render_target_pool.h"
+#include "ogl/fence.h"
 #include "ogl/vbo.h"
 #include "ogl/ebo.h"
 
@@ -61,6 +64,7 @@
 #include "render_nodes/multi_render_node.h"
 #include "render_nodes/multi_render_node_interleaved_xyuv.h"
 #include "render_nodes/p4_render_node.h"
+#include "render_nodes/batch_render_node.h"
 
 // internal
 #include "_internal/main_shader_program.h"
@@ -77,6 +81,7 @@
 #include "samplers/shapes/rounded_rect_sampler.h"
 #include "samplers/color_sampler.h"
 #include "samplers/tint_sampler.h"
+#include "samplers/sdf_text_sampler.h"
 #include "samplers/channel_sampler.h"
 #include "samplers/shapes/arc_sampler.h"
 #include "samplers/shapes/pie_sampler.h"
@@ -117,12 +122,104 @@ namespace nitrogl {
         draw_mode _draw_mode;
         bool _is_pre_mul_alpha;
 
+        // offscreen layers
+        struct layer_t {
+            fbo_t fbo; // kept alive and re-attached, when the stack grows again
+            gl_texture texture, backdrop;
+            rect_i bounds;
+            float opacity;
+            blend_mode_t blend_mode;
+            compositor_t alpha_compositor;
+            // the state of the canvas before the layer was pushed
+            window_t window;
+            vec2f origin;
+            blend_mode_t saved_blend_mode;
+            compositor_t saved_alpha_compositor;
+            bool saved_pre_mul_alpha;
+        };
+        using layers_allocator_t = nitrogl::std_rebind_allocator<layer_t>;
+        dynamic_array<layer_t, layers_allocator_t> _layers;
+        unsigned _layers_depth;
+        vec2f _origin; // canvas coordinates of the top-left of the render target
+
+        /**
+         * uvs derivatives, see `update_uv_derivatives`. Degenerate transforms are not valid
+         */
+        struct uv_derivatives_t {
+            float du_dx, dv_dx, du_dy, dv_dy;
+            bool valid;
+
+            void apply(sampler_t & sampler) const {
+                if(valid) sampler.update_uv_derivatives(du_dx, dv_dx, du_dy, dv_dy);
+            }
+            bool operator==(const uv_derivatives_t & o) const {
+                return valid==o.valid && (!valid || (du_dx==o.du_dx && dv_dx==o.dv_dx &&
+                                                     du_dy==o.du_dy && dv_dy==o.dv_dy));
+            }
+        };
+
+        // small draws, that were transformed on the cpu and wait to be drawn as one vertex
+        // stream with identity matrices, see updatePreTransformThreshold
+        struct pre_transformed_t {
+            using vec2_allocator_t = nitrogl::std_rebind_allocator<vec2f>;
+            using index_allocator_t = nitrogl::std_rebind_allocator<index>;
+            using rect_allocator_t = nitrogl::std_rebind_allocator<rectf>;
+            dynamic_array<vec2f, vec2_allocator_t> pos, uvs;
+            dynamic_array<index, index_allocator_t> indices;
+            // canvas bounds of the merged draws, a draw that overlaps them is not merged
+            dynamic_array<rectf, rect_allocator_t> bounds;
+            // null when nothing is pending
+            main_shader_program * program;
+            sampler_t * sampler;
+            nitrogl::uintptr_type key, uniforms_version;
+            float opacity;
+            // samplers, that read uvs derivatives, see those of their draws, so they must be equal
+            uv_derivatives_t uv_derivatives;
+            // depth of internal_sampler_scope, draws are not merged inside of it
+            unsigned suspended;
+
+            pre_transformed_t() : pos(), uvs(), indices(), bounds(), program(nullptr),
+                                  sampler(nullptr), key(0), uniforms_version(0), opacity(1.0f),
+                                  uv_derivatives{0.0f, 0.0f, 0.0f, 0.0f, false}, suspended(0) {}
+        };
+        index _pre_transform_threshold;
+        pre_transformed_t _pre_transformed;
+        // merged streams stay with 16 bit indices, and overlap tests stay short
+        static constexpr index max_pre_transformed_vertices = 1u<<16;
+        static constexpr index max_pre_transformed_draws = 256;
+
+#ifdef NITROGL_SUPPORTS_FENCE_SYNC
+        // rotating frame targets, see updateFrameTargets
+        struct frame_target_t {
+            // while the target records a frame, it holds the target of the canvas instead
+            fbo_t fbo;
+            gl_texture texture;
+            // completion of the last frame, that was recorded into the target
+            fence_t fence;
+        };
+        struct frames_t {
+            using targets_allocator_t = nitrogl::std_rebind_allocator<frame_target_t>;
+            dynamic_array<frame_target_t, targets_allocator_t> targets;
+            unsigned current; // the target of the next (or the recorded) frame
+            bool recording;
+
+            frames_t() : targets(), current(0), recording(false) {}
+        };
+        frames_t _frames;
+#endif
+
         static static_alloc get_static_allocator() {
             // static allocator, shared by all canvases
             static static_alloc allocator_static;
             return allocator_static;
         }
 
+        static render_target_pool<> & layers_pool() {
+            // render targets of layers are shared among all canvas instances
+            static render_target_pool<> pool{8};
+            return pool;
+        }
+
         static lru_main_shader_pool_t & lru_main_shader_pool() {
             // shader pool is shared among all canvas instances
             static lru_main_shader_pool_t pool{0.5f, get_static_allocator()};
@@ -147,8 +244,9 @@ namespace nitrogl {
 
     public:
         void generate_backdrop() {
+            flush();
             // move
-            _tex_backdrop = gl_texture::empty(width(), height(), GL_RGBA, _is_pre_mul_alpha,
+            _tex_backdrop = gl_texture::empty(width(), height(), GL_RGBA, _is_pre_mul_alpha, 1,
                                          GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
         }
 
@@ -160,6 +258,197 @@ namespace nitrogl {
             _blend_mode=blend_mode; _alpha_compositor=alpha_compositor;
         }
 
+        /**
+         * Start an offscreen layer. Draws after this call render into a layer sized texture,
+         * until `pop_layer()` composites the layer back with one textured quad, using the
+         * group opacity, blend mode and alpha compositor. Layers can be nested.
+         * - render targets come from a LRU pool of textures, that is shared by all canvases
+         * - coordinates stay in canvas space, draws outside of the layer are discarded
+         * - the clip rect is kept, it is clipped to the layer bounds
+         * - layers are pre-multiplied alpha and start transparent
+         * @param rect layer bounds in canvas coordinates
+         * @param opacity group opacity [0..1]
+         * @param blend_mode group blend mode
+         * @param alpha_compositor group alpha compositor (usually Porter-Duff operator)
+         */
+        void push_layer(const rect_i & rect, float opacity=1.0f,
+                        blend_mode_t blend_mode=blend_modes::Normal(),
+                        compositor_t alpha_compositor=porter_duff::SourceOver()) {
+            flush();
+            const int w = rect.width()<1 ? 1 : rect.width();
+            const int h = rect.height()<1 ? 1 : rect.height();
+            if(_layers_depth==_layers.size())
+                _layers.push_back({ fbo_t(), gl_texture::un_generated_dummy(),
+                                    gl_texture::un_generated_dummy(), rect, opacity,
+                                    blend_mode, alpha_compositor, _window, _origin,
+                                    _blend_mode, _alpha_compositor, _is_pre_mul_alpha });
+            auto & layer = _layers[_layers_depth++];
+            layer.texture = layers_pool().acquire(w, h, true);
+            layer.backdrop = layers_pool().acquire(w, h, true);
+            layer.bounds = rect_i{rect.left, rect.top, rect.left + w, rect.top + h};
+            layer.opacity = opacity;
+            layer.blend_mode = blend_mode; layer.alpha_compositor = alpha_compositor;
+            layer.window = _window; layer.origin = _origin;
+            layer.saved_blend_mode = _blend_mode; layer.saved_alpha_compositor = _alpha_compositor;
+            layer.saved_pre_mul_alpha = _is_pre_mul_alpha;
+            // re-target the canvas into the layer
+            layer.fbo.attachTexture(layer.texture);
+            swap_render_target(layer);
+            // the clip rect moves into the layer pixels, restored by `pop_layer()`
+            _window.canvas_rect = rect_i{0, 0, w, h};
+            _window.clip_rect = rect_i(_window.clip_rect).translate(int(_origin.x) - rect.left,
+                                        int(_origin.y) - rect.top).intersect(_window.canvas_rect);
+            _origin = vec2f(float(rect.left), float(rect.top));
+            _is_pre_mul_alpha = true;
+            clear(0.0f, 0.0f, 0.0f, 0.0f);
+        }
+
+        /**
+         * Composite the last pushed layer into the layer below it (or the canvas)
+         */
+        void pop_layer() {
+            if(_layers_depth==0) return;
+            flush();
+            auto & layer = _layers[--_layers_depth];
+            swap_render_target(layer);
+            _window = layer.window; _origin = layer.origin;
+            _is_pre_mul_alpha = layer.saved_pre_mul_alpha;
+            // composite with a single textured quad, always filled
+            const internal_sampler_scope internal_scope{*this};
+            texture_sampler sampler{layer.texture};
+            if(_draw_mode!=draw_mode::fill) glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            update_composition(layer.blend_mode, layer.alpha_compositor);
+            drawRect(sampler, float(layer.bounds.left), float(layer.bounds.top),
+                     float(layer.bounds.right), float(layer.bounds.bottom), layer.opacity);
+            update_composition(layer.saved_blend_mode, layer.saved_alpha_compositor);
+            if(_draw_mode!=draw_mode::fill) updateDrawMode(_draw_mode);
+            layers_pool().release(layer.texture);
+            layers_pool().release(layer.backdrop);
+            layer.texture = gl_texture::un_generated_dummy();
+            layer.backdrop = gl_texture::un_generated_dummy();
+        }
+
+        /**
+         * @return how many layers are pushed
+         */
+        unsigned layers_depth() const { return _layers_depth; }
+
+#ifdef NITROGL_SUPPORTS_FENCE_SYNC
+    private:
+        void swap_frame_target(frame_target_t & target) {
+            fbo_t fbo = nitrogl::traits::move(_fbo);
+            _fbo = nitrogl::traits::move(target.fbo);
+            target.fbo = nitrogl::traits::move(fbo);
+        }
+
+    public:
+        /**
+         * Record frames into `count` rotating target textures of the canvas size, so the CPU
+         * records the next frame without waiting for the GPU (or a read back) of the last one.
+         * - `beginFrame()` re-targets the canvas to the next target. It blocks only if all the
+         *   targets are in flight, until the frame, that was recorded `count` frames ago into
+         *   the target, is complete.
+         * - `endFrame()` fences the frame and returns the canvas to its own target.
+         * - `isFrameComplete`, `waitFrame` and `readFramePixels` consume the frames, a frame
+         *   stays valid until its target is recorded again, `count` frames later.
+         * Targets keep their last frame, so clear them. A frame begins without layers, and
+         * `endFrame` pops the layers, that were pushed during the frame.
+         * Targets follow the size of the canvas window, see `updateCanvasWindow`.
+         * @param count how many targets (3 for triple buffering), 0 deletes the targets
+         */
+        void updateFrameTargets(unsigned count) {
+            if(_frames.recording) endFrame();
+            flush();
+            for (auto & target : _frames.targets) target.texture.del();
+            _frames.targets.clear();
+            for (unsigned ix = 0; ix < count; ++ix) {
+                _frames.targets.push_back({ fbo_t(),
+                                            gl_texture::empty(GLsizei(width()), GLsizei(height()),
+                                                              GL_RGBA, _is_pre_mul_alpha, 1,
+                                                              GL_LINEAR, GL_LINEAR,
+                                                              GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE),
+                                            fence_t() });
+                auto & target = _frames.targets[_frames.targets.size()-1];
+                target.fbo.attachTexture(target.texture);
+            }
+            _frames.current = 0;
+        }
+        unsigned frameTargets() const { return _frames.targets.size(); }
+
+        /**
+         * start recording a frame into the next target, see `updateFrameTargets`.
+         * Ignored while layers are pushed, they render into their own targets.
+         */
+        void beginFrame() {
+            if(_frames.targets.size()==0 || _frames.recording || _layers_depth) return;
+            flush();
+            auto & target = _frames.targets[_frames.current];
+            // back-pressure, the target is still in flight from `count` frames ago
+            target.fence.wait();
+            swap_frame_target(target);
+            _frames.recording = true;
+            // the backdrop follows the render target
+            copy_to_backdrop();
+        }
+
+        /**
+         * end the recorded frame, the GPU completes it asynchronously
+         * @return the index of the target of the frame, -1 if no frame was begun
+         */
+        int endFrame() {
+            if(!_frames.recording) return -1;
+            // layers of the frame are composited into it, so the canvas owns its target again
+            while(_layers_depth) pop_layer();
+            flush();
+            const unsigned ix = _frames.current;
+            auto & target = _frames.targets[ix];
+            swap_frame_target(target);
+            target.fence.insert();
+            // submit the fence, so it gets signaled without a wait, that flushes
+            glFlush();
+            _frames.recording = false;
+            _frames.current = (ix + 1) % _frames.targets.size();
+            copy_to_backdrop();
+            return int(ix);
+        }
+
+        /**
+         * the texture of a frame target, it may be sampled, once the frame is complete
+         */
+        const gl_texture & frameTexture(unsigned ix) const { return _frames.targets[ix].texture; }
+
+        /**
+         * non blocking query, if the GPU has completed the last frame of a target
+         */
+        bool isFrameComplete(unsigned ix) const { return _frames.targets[ix].fence.isSignaled(); }
+
+        /**
+         * block until the GPU completes the last frame of a target
+         * @return false if the timeout expired first, or the wait failed
+         */
+        bool waitFrame(unsigned ix, GLuint64 timeout_ns=GLuint64(~0ull)) {
+            return _frames.targets[ix].fence.wait(timeout_ns);
+        }
+
+        /**
+         * wait for the last frame of a target and read it back. Rows are bottom to top
+         * @param pixels RGBA8 output of width*height*4 bytes
+         * @return false if the frame was not ended yet, or waiting for it failed
+         */
+        bool readFramePixels(unsigned ix, void * pixels) {
+            if(_frames.recording && ix==_frames.current) return false; // not ended yet
+            if(!waitFrame(ix)) return false;
+            const auto & target = _frames.targets[ix];
+            target.fbo.bind_read();
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, target.texture.width(), target.texture.height(),
+                         GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            glCheckError();
+            fbo_t::unbind();
+            return true;
+        }
+#endif
+
 
         // if wants AA:
         // 1. create RBO with multisampling and attach it to color in fbo_t, and then blit to texture's fbo_t
@@ -169,7 +458,10 @@ namespace nitrogl {
                                                   _is_pre_mul_alpha(tex.is_premul_alpha()),
                                                   _blend_mode(blend_modes::Normal()),
                                                   _alpha_compositor(porter_duff::SourceOver()),
-                                                  _draw_mode(draw_mode::fill) {
+                                                  _draw_mode(draw_mode::fill),
+                                                  _layers(layers_allocator_t()), _layers_depth(0),
+                                                  _origin(0.0f, 0.0f), _pre_transform_threshold(0),
+                                                  _pre_transformed() {
             _fbo.attachTexture(tex);
             internal_init(tex.width(), tex.height());
         }
@@ -179,7 +471,8 @@ namespace nitrogl {
                 _tex_backdrop(gl_texture::un_generated_dummy()), _fbo(fbo_t::from_current()),
                 _node_multi(), _node_p4(), _node_multi_interleaved(), _window(), _is_pre_mul_alpha(is_pre_mul_alpha),
                 _blend_mode(blend_modes::Normal()), _alpha_compositor(porter_duff::SourceOver()),
-                _draw_mode(draw_mode::fill) {
+                _draw_mode(draw_mode::fill), _layers(layers_allocator_t()), _layers_depth(0),
+                _origin(0.0f, 0.0f), _pre_transform_threshold(0), _pre_transformed() {
             internal_init(width, height);
         }
 
@@ -188,11 +481,82 @@ namespace nitrogl {
          * @param mode enum { draw_mode::fill, draw_mode::line, draw_mode::point }
          */
         void updateDrawMode(draw_mode mode) {
+            flush();
             _draw_mode = mode;
             GLenum mode_gl = int(_draw_mode);
             glPolygonMode(GL_FRONT_AND_BACK, mode_gl);
         }
 
+        /**
+         * Change the vertex format of triangles, paths and shapes. Compact layouts upload
+         * interleaved 16 bit fixed point positions and/or half/normalized uvs, see vertex_layout
+         * @param layout the layout, the default is full float streams
+         */
+        void updateVertexLayout(const vertex_layout & layout) {
+            flush();
+            _node_multi.updateVertexLayout(layout);
+        }
+        const vertex_layout & vertexLayout() const { return _node_multi.vertexLayout(); }
+
+        /**
+         * Transform the vertices of small draws on the CPU and draw them with identity matrices,
+         * so consecutive small draws with the same program are merged into one vertex stream
+         * and one draw call, regardless of their transforms. Merged are `drawTriangles` of
+         * TRIANGLES (paths too) and `drawRect`, with an affine transform and at most
+         * `max_vertices` vertices.
+         * NOTES:
+         * 1. merged draws are deferred until a draw, that does not merge, or `flush()`.
+         *    Call `flush()` before reading the render target.
+         * 2. only draws of samplers, that opted in with `sampler_t::set_mergeable(true)`, are
+         *    merged. They must stay alive (no temporaries) until they are drawn. Draws merge
+         *    with the same sampler object and uniforms version only, so uniforms, that are
+         *    assigned directly, require `invalidate_uniforms()` in between.
+         * 3. a draw, that overlaps a merged draw, starts a new merge, so blending is not
+         *    affected. So does a draw with other uvs derivatives (another scale or rotation),
+         *    if the sampler reads them, see `texture_sampler::setLODMode`.
+         * 4. draws of samplers, that the canvas creates internally (masks, shapes, text,
+         *    layers), are not merged.
+         * @param max_vertices the vertices threshold, 0 disables the mode (default)
+         */
+        void updatePreTransformThreshold(index max_vertices) {
+            flush();
+            _pre_transform_threshold = max_vertices;
+        }
+        index preTransformThreshold() const { return _pre_transform_threshold; }
+
+        /**
+         * draw the merged draws, that are pending, see `updatePreTransformThreshold`
+         */
+        void flush() {
+            auto & p = _pre_transformed;
+            if(p.program==nullptr) return;
+            glViewport(0, 0, GLsizei(width()), GLsizei(height()));
+            _fbo.bind();
+            // inverted y projection, canvas coords to opengl
+            auto mat_proj = projection();
+            using size_type = multi_render_node::size_type;
+            multi_render_node::data_type data = {
+                    p.pos.data(), p.uvs.data(), nullptr, p.indices.data(),
+                    size_type(p.pos.size()), size_type(p.uvs.size()), 0,
+                    size_type(p.indices.size()), GL_UNSIGNED_INT,
+                    GLenum(triangles::indices::TRIANGLES),
+                    mat4f::identity(),
+                    mat4f::identity(),
+                    mat_proj,
+                    mat3f::identity(),
+                    _tex_backdrop,
+                    width(), height(),
+                    p.opacity,
+                    rectf() // uvs are not generated
+            };
+            glDisable(GL_BLEND);
+            _node_multi.render(*p.program, *p.sampler, data);
+            glEnable(GL_BLEND);
+            fbo_t::unbind();
+            discard_pre_transformed();
+            copy_to_backdrop();
+        }
+
         /**
          * update the clipping rectangle of the canvas
          *
@@ -214,14 +578,45 @@ namespace nitrogl {
          * @param bottom relative to y=0
          */
         void updateCanvasWindow(int left, int top, int right, int bottom) {
+            flush();
+#ifdef NITROGL_SUPPORTS_FENCE_SYNC
+            const bool resized = _layers_depth==0 && _frames.targets.size() &&
+                                 (unsigned(right)!=width() || unsigned(bottom)!=height());
+            if(resized && _frames.recording) endFrame();
+#endif
             _window.canvas_rect = rect_i{left, top, left + right, top + bottom };
             if(_window.clip_rect.empty()) _window.clip_rect=_window.canvas_rect;
+#ifdef NITROGL_SUPPORTS_FENCE_SYNC
+            // frame targets have the size of the canvas
+            if(resized) updateFrameTargets(_frames.targets.size());
+#endif
         }
 
         void updateCanvasWindow(int left, int top) {
             updateCanvasWindow(left, top, width(), height());
         }
 
+        /**
+         * Render into another texture. The fbo, render nodes and shaders are kept, and the
+         * backdrop is reallocated only if the size or alpha mode changes, so it is cheaper than
+         * a new canvas per texture. The clip rect and the canvas window are reset.
+         * Ignored while layers are pushed.
+         */
+        void updateRenderTarget(const gl_texture & tex) {
+            if(_layers_depth) return;
+            flush();
+            const bool reallocate = !_tex_backdrop.wasGenerated() ||
+                    _tex_backdrop.width()!=tex.width() || _tex_backdrop.height()!=tex.height() ||
+                    _is_pre_mul_alpha!=tex.is_premul_alpha();
+            _fbo.attachTexture(tex);
+            fbo_t::unbind();
+            _is_pre_mul_alpha = tex.is_premul_alpha();
+            updateClipRect(0, 0, tex.width(), tex.height());
+            updateCanvasWindow(0, 0, tex.width(), tex.height());
+            if(reallocate) generate_backdrop();
+            copy_to_backdrop();
+        }
+
         /**
          * given that we know the canvas size and the clip rect_i, calculate
          * the sub rectangle (intersection), where drawing is visible
@@ -249,10 +644,12 @@ namespace nitrogl {
         // get canvas height
         unsigned int height() const { return _window.canvas_rect.height(); };
         // get the pixels array from the underlying bitmap
-        void clear(const color_t &color) const {
+        void clear(const color_t &color) {
             clear(color.r, color.g, color.b, color.a);
         }
-        void clear(float r, float g, float b, float a) const {
+        void clear(float r, float g, float b, float a) {
+            // merged draws, that are pending, are cleared anyway
+            discard_pre_transformed();
             _fbo.bind();
             if(_is_pre_mul_alpha) { r*=a; g*=a; b*=a; }
             glClearColor(r, g, b, a);
@@ -262,6 +659,15 @@ namespace nitrogl {
         }
 
     private:
+        void swap_render_target(layer_t & layer) {
+            fbo_t fbo = nitrogl::traits::move(_fbo);
+            _fbo = nitrogl::traits::move(layer.fbo);
+            layer.fbo = nitrogl::traits::move(fbo);
+            gl_texture backdrop = nitrogl::traits::move(_tex_backdrop);
+            _tex_backdrop = nitrogl::traits::move(layer.backdrop);
+            layer.backdrop = nitrogl::traits::move(backdrop);
+        }
+
         void copy_region_to_backdrop(int left, int top, int right, int bottom) const {
             copy_region_to_texture(_tex_backdrop, left, top, left, top, right, bottom);
         }
@@ -291,23 +697,42 @@ namespace nitrogl {
         }
 
         /**
-         * Given a sampler, generate the main shader of it and use the pool
-         * to get it or update it
-         * @param sampler Sampler object
-         * @return a program
+         * the key of the main shader of a sampler in the pool, see
+         * `get_main_shader_program_for_sampler`
          */
-        main_shader_program & get_main_shader_program_for_sampler(
-                sampler_t & sampler) {
+        nitrogl::uintptr_type main_shader_program_key(sampler_t & sampler,
+                                                      bool generated_uvs, bool batched) const {
             // we always regenerate a traversal because parts of a sampler
             // tree may have been used in another sampler, which might have
             // written the traversal info
             sampler.generate_traversal(0);
             microc::iterative_murmur<nitrogl::uintptr_type> murmur;
             const auto sampler_key = sampler.hash_code();
-            const auto key = murmur.begin(sampler_key)
+            return murmur.begin(sampler_key)
                   .next(_is_pre_mul_alpha ? 0 : 1)
                   .next_cast(_blend_mode)
-                  .next_cast(_alpha_compositor).end();
+                  .next_cast(_alpha_compositor)
+                  .next(generated_uvs ? 1 : 0)
+                  .next(batched ? 1 : 0).end();
+        }
+
+        /**
+         * Given a sampler, generate the main shader of it and use the pool
+         * to get it or update it
+         * @param sampler Sampler object
+         * @param generated_uvs use the vertex shader variant, that generates uvs from the bbox
+         * @param batched use the vertex shader variant, that reads per draw data of batches
+         * @return a program
+         */
+        main_shader_program & get_main_shader_program_for_sampler(
+                sampler_t & sampler, bool generated_uvs=false, bool batched=false) {
+            // merged draws hold a program of the pool, draw them before it may be recycled.
+            // the flush unbinds the render target, that callers have bound by now
+            if(_pre_transformed.program) {
+                flush();
+                _fbo.bind();
+            }
+            const auto key = main_shader_program_key(sampler, generated_uvs, batched);
             auto & pool = lru_main_shader_pool();
             auto res = pool.get(key);
             auto & program = res.object;
@@ -317,11 +742,21 @@ namespace nitrogl {
                         program,sampler,
                         ogl_info::glsl_version_string,
                         _is_pre_mul_alpha,
-                        _blend_mode, _alpha_compositor);
+                        _blend_mode, _alpha_compositor, generated_uvs, batched);
             }
             return program;
         }
 
+        /**
+         * inverted y orthographic projection, canvas coords to opengl. Inside a layer,
+         * the render target starts at the origin of the layer.
+         */
+        mat4f projection() const {
+            return camera::orthographic<float>(_origin.x, _origin.x + float(width()),
+                                               _origin.y + float(height()), _origin.y,
+                                               -1.0f, 1.0f);
+        }
+
         /**
          * Prepare a UV transform:
          * 1. Focus on a rectangle (u0, v0, u1, v1)
@@ -357,6 +792,179 @@ namespace nitrogl {
             return transform_uv;
         }
 
+        /**
+         * Let the samplers know the rate of change of their uv coordinates per canvas pixel,
+         * assuming the uvs are stretched on the bounding box. Samplers may use it for client
+         * side level of detail selection, see `texture_sampler::setLODMode`.
+         * @param sampler the sampler
+         * @param transform vertices transform
+         * @param transform_uv the prepared UV transform
+         * @param bbox_width object bounding box width
+         * @param bbox_height object bounding box height
+         */
+        static void update_uv_derivatives(sampler_t & sampler,
+                                          const mat3f & transform, const mat3f & transform_uv,
+                                          float bbox_width, float bbox_height) {
+            uv_derivatives(transform, transform_uv, bbox_width, bbox_height).apply(sampler);
+        }
+
+        static uv_derivatives_t uv_derivatives(const mat3f & transform, const mat3f & transform_uv,
+                                               float bbox_width, float bbox_height) {
+            // J = uv_linear * diag(1/w, 1/h) * inverse(transform_linear)
+            const float a=transform(0,0), b=transform(0,1), c=transform(1,0), d=transform(1,1);
+            const float det = a*d - b*c;
+            if(det==0.0f || bbox_width<=0.0f || bbox_height<=0.0f)
+                return { 0.0f, 0.0f, 0.0f, 0.0f, false };
+            const float i00=d/det, i01=-b/det, i10=-c/det, i11=a/det;
+            const float sx=1.0f/bbox_width, sy=1.0f/bbox_height;
+            const float u00=transform_uv(0,0)*sx, u01=transform_uv(0,1)*sy;
+            const float u10=transform_uv(1,0)*sx, u11=transform_uv(1,1)*sy;
+            return { u00*i00 + u01*i10, u10*i00 + u11*i10,
+                     u00*i01 + u01*i11, u10*i01 + u11*i11, true };
+        }
+
+        /**
+         * draws of canvas internal samplers, that live on the stack of a draw method, are
+         * never deferred by the pre-transform mode, their samplers are gone by the flush.
+         * pending draws are flushed first, internal samplers pass uvs derivatives down to
+         * the user samplers, that they wrap.
+         */
+        struct internal_sampler_scope {
+            canvas & c;
+            explicit internal_sampler_scope(canvas & owner) : c(owner) {
+                c.flush();
+                ++c._pre_transformed.suspended;
+            }
+            ~internal_sampler_scope() { --c._pre_transformed.suspended; }
+        };
+
+        void discard_pre_transformed() {
+            auto & p = _pre_transformed;
+            p.pos.clear(); p.uvs.clear(); p.indices.clear(); p.bounds.clear();
+            p.program = nullptr; p.sampler = nullptr;
+        }
+
+        /**
+         * Merge a draw of TRIANGLES into the pending pre-transformed draws, see
+         * `updatePreTransformThreshold`. The vertices are transformed on the CPU and the uvs
+         * are resolved with the uvs transform, so the stream is drawn with identity matrices.
+         * @param uvs (Optional) null uvs are generated from the bbox, same as the vertex shader
+         * @param bbox bbox of the vertices, before the transform
+         * @param transform vertices transform, about its origin
+         * @param transform_uv the prepared uvs transform
+         * @param uv_derivatives uvs derivatives of the draw, the sampler gets them
+         * @return false if the draw is not eligible, it should be drawn as usual
+         */
+        template<class index_type>
+        bool merge_pre_transformed(sampler_t & sampler,
+                                   const vec2f * vertices, index vertices_size,
+                                   const index_type * indices, index indices_size,
+                                   const vec2f * uvs, const rectf & bbox,
+                                   const mat3f & transform, const mat3f & transform_uv,
+                                   float opacity, const uv_derivatives_t & uv_derivatives) {
+            auto & p = _pre_transformed;
+            if(p.suspended || !sampler.mergeable() || vertices_size==0 ||
+               vertices_size>_pre_transform_threshold || !transform.isAffine()) return false;
+            // conservative bounds, the transformed corners of the bbox
+            const vec2f corners[4] = { {bbox.left, bbox.top}, {bbox.right, bbox.top},
+                                       {bbox.right, bbox.bottom}, {bbox.left, bbox.bottom} };
+            vec2f transformed_corners[4];
+            vec2_kernels::transform(transform, corners, transformed_corners, 4);
+            const rectf bounds = vec2_kernels::bbox(transformed_corners, 4);
+            const auto key = main_shader_program_key(sampler, false, false);
+            const auto uniforms_version = sampler.uniforms_version();
+            bool merges = p.program && p.key==key && p.sampler==&sampler &&
+                          p.uniforms_version==uniforms_version && p.opacity==opacity &&
+                          (p.uv_derivatives==uv_derivatives || !sampler.uses_uv_derivatives()) &&
+                          p.pos.size() + vertices_size <= max_pre_transformed_vertices &&
+                          p.bounds.size() < max_pre_transformed_draws;
+            for (index ix = 0; merges && ix < p.bounds.size(); ++ix)
+                merges = !p.bounds[ix].intersects(bounds);
+            if(!merges) {
+                flush();
+                p.program = &get_main_shader_program_for_sampler(sampler);
+                p.sampler = &sampler; p.key = key;
+                p.uniforms_version = uniforms_version; p.opacity = opacity;
+                p.uv_derivatives = uv_derivatives;
+                uv_derivatives.apply(sampler);
+            }
+            const index base = p.pos.size();
+            p.pos.resize(base + vertices_size);
+            p.uvs.resize(base + vertices_size);
+            vec2_kernels::transform(transform, vertices, p.pos.data() + base, vertices_size);
+            if(uvs) vec2_kernels::transform(transform_uv, uvs, p.uvs.data() + base, vertices_size);
+            else {
+                // uv = (pos - bbox.left_top)/bbox.size and flipped v, same as the vertex shader
+                mat3f generate = transform_uv;
+                generate *= mat3f::translate(0.0f, 1.0f);
+                generate *= mat3f::scale(1.0f/bbox.width(), -1.0f/bbox.height());
+                generate *= mat3f::translate(-bbox.left, -bbox.top);
+                vec2_kernels::transform(generate, vertices, p.uvs.data() + base, vertices_size);
+            }
+            const index count = indices ? indices_size : vertices_size;
+            const index start = p.indices.size();
+            p.indices.resize(start + count);
+            auto * out = p.indices.data() + start;
+            for (index ix = 0; ix < count; ++ix)
+                out[ix] = base + (indices ? index(indices[ix]) : ix);
+            p.bounds.push_back(bounds);
+            return true;
+        }
+
+#ifdef NITROGL_SUPPORTS_BATCHING
+    public:
+        /**
+         * a draw of `drawTrianglesBatch`
+         */
+        struct batch_draw {
+            const vec2f * vertices;
+            index vertices_size;
+            // (Optional) null indices draw the vertices in order
+            const index * indices;
+            index indices_size;
+            // (Optional) all the draws of a batch have uvs, or none of them has
+            const vec2f * uvs;
+            mat3f transform;
+            float opacity;
+            mat3f transform_uv;
+        };
+
+    private:
+        static batch_render_node & batch_node() {
+            // batch node is shared among all canvas instances, and created on first use
+            static batch_render_node node;
+            if(!node.wasInitialized()) node.init();
+            return node;
+        }
+
+        /**
+         * feeds the batch node, the per draw data is resolved like in `drawTriangles`
+         */
+        struct batch_draws_source {
+            const batch_draw * draws;
+            index draws_size;
+            float intrinsic_width, intrinsic_height;
+
+            index size() const { return draws_size; }
+            batch_render_node::draw_type geometry(batch_render_node::size_type ix) const {
+                const auto & d = draws[ix];
+                return { d.vertices, d.uvs, d.indices, d.vertices_size, d.indices_size };
+            }
+            batch_render_node::draw_data_type resolve(batch_render_node::size_type ix) const {
+                const auto & d = draws[ix];
+                const auto bbox = nitrogl::triangles::triangles_bbox(d.vertices, d.vertices_size,
+                                                                     d.indices, d.indices_size);
+                mat3f transform = d.transform, transform_uv = d.transform_uv;
+                prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
+                                     intrinsic_width, intrinsic_height);
+                // make the transform about its origin, a nice feature
+                transform.post_translate(vec2f(-bbox.left, -bbox.top))
+                         .pre_translate(vec2f(bbox.left, bbox.top));
+                return { transform, transform_uv, d.opacity, bbox };
+            }
+        };
+#endif
+
     public:
 
         /**
@@ -385,6 +993,28 @@ namespace nitrogl {
                            index indices_size=0,
                            const vec2f * uvs=nullptr,
                            index uvs_size=0,
+                           const mat3f & transform = mat3f::identity(),
+                           float opacity=1.0f,
+                           const mat3f & transform_uv = mat3f::identity(),
+                           float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            drawTriangles<index>(sampler, type, vertices, vertices_size, indices, indices_size,
+                                 uvs, uvs_size, transform, opacity, transform_uv, u0, v0, u1, v1);
+        }
+
+        /**
+         * Draw a batch of triangles with 16 bit (GLushort) or 8 bit (GLubyte) indices.
+         * Same as the above, 32 bit indices are narrowed to 16 bit anyway, when they fit.
+         * @tparam index_type GLuint, GLushort or GLubyte
+         */
+        template<class index_type>
+        void drawTriangles(const sampler_t & sampler,
+                           enum triangles::indices type,
+                           const vec2f * vertices,
+                           index vertices_size,
+                           const index_type * indices,
+                           index indices_size,
+                           const vec2f * uvs=nullptr,
+                           index uvs_size=0,
                            mat3f transform = mat3f::identity(),
                            float opacity=1.0f,
                            mat3f transform_uv = mat3f::identity(),
@@ -398,23 +1028,30 @@ namespace nitrogl {
             prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
                                  sampler.intrinsic_width, sampler.intrinsic_height,
                                  u0, v0, u1, v1);
+            const auto derivatives = uv_derivatives(transform, transform_uv,
+                                                    bbox.width(), bbox.height());
+            // make the transform about its origin, a nice feature
+            transform.post_translate(vec2f(-bbox.left, -bbox.top))
+                     .pre_translate(vec2f(bbox.left, bbox.top));
+            if(type==triangles::indices::TRIANGLES && (uvs==nullptr || uvs_size>=vertices_size) &&
+               merge_pre_transformed(sampler_casted, vertices, vertices_size, indices, indices_size,
+                                     uvs, bbox, transform, transform_uv, opacity, derivatives))
+                return;
+            // after the merge, that may flush draws, that see the derivatives of their own
+            derivatives.apply(sampler_casted);
 
             //
             glViewport(0, 0, GLsizei(width()), GLsizei(height()));
             _fbo.bind();
             // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
-            // make the transform about its origin, a nice feature
-            transform.post_translate(vec2f(-bbox.left, -bbox.top))
-                     .pre_translate(vec2f(bbox.left, bbox.top));
+            auto mat_proj = projection();
             // buffers
-            auto & program = get_main_shader_program_for_sampler(sampler_casted);
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, uvs==nullptr);
             // data
             multi_render_node::data_type data = {
                     vertices, uvs, nullptr, indices,
                     vertices_size, uvs_size, 0, indices_size,
+                    triangles::gl_index_type<index_type>::value,
                     GLenum(type),
                     mat4f(transform), // promote it to mat4x4
                     mat4f::identity(),
@@ -465,14 +1102,13 @@ namespace nitrogl {
             prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
                                  sampler.intrinsic_width, sampler.intrinsic_height,
                                  u0, v0, u1, v1);
+            update_uv_derivatives(sampler_casted, transform, transform_uv, bbox.width(), bbox.height());
 
             //
             glViewport(0, 0, GLsizei(width()), GLsizei(height()));
             _fbo.bind();
             // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
+            auto mat_proj = projection();
             // make the transform about its origin, a nice feature
             transform.post_translate(vec2f(-bbox.left, -bbox.top)).pre_translate(vec2f(bbox.left, bbox.top));
             // buffers
@@ -497,10 +1133,88 @@ namespace nitrogl {
             copy_to_backdrop();
         }
 
+#ifdef NITROGL_SUPPORTS_BATCHING
+        /**
+         * Draw many meshes with a shared sampler in a few draw calls, instead of a draw call
+         * per mesh. Each draw is like `drawTriangles` with it's own transform, opacity and uvs
+         * transform. Fold uv windows into `transform_uv`.
+         * NOTES:
+         * 1. all the draws sample the same sampler with the same uniforms
+         * 2. all the draws composite with the backdrop, that was before the batch, so draws,
+         *    that overlap each other, do not blend with each other
+         * 3. either all the draws have uvs or none of them has
+         * @param sampler the sampler to sample from
+         * @param type Type of triangles {Triangles, Fan, Strip}
+         * @param draws The draws array pointer
+         * @param draws_size The size of draws array
+         */
+        void drawTrianglesBatch(const sampler_t & sampler,
+                                enum triangles::indices type,
+                                const batch_draw * draws,
+                                index draws_size) {
+            if(draws==nullptr || draws_size==0) return;
+            auto & sampler_casted = const_cast<sampler_t &>(sampler);
+            const batch_draws_source source = { draws, draws_size,
+                                                sampler.intrinsic_width, sampler.intrinsic_height };
+            {   // samplers get the uvs derivatives of the first draw
+                const auto first = source.resolve(0);
+                update_uv_derivatives(sampler_casted, draws[0].transform, first.transform_uvs,
+                                      first.bbox.width(), first.bbox.height());
+            }
+
+            //
+            glViewport(0, 0, GLsizei(width()), GLsizei(height()));
+            _fbo.bind();
+            // inverted y projection, canvas coords to opengl
+            auto mat_proj = projection();
+            const bool has_uvs = draws[0].uvs!=nullptr;
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, !has_uvs, true);
+            // data
+            batch_render_node::data_type data = {
+                    GLenum(type), has_uvs,
+                    mat4f::identity(),
+                    mat_proj,
+                    _tex_backdrop,
+                    width(), height()
+            };
+            glDisable(GL_BLEND);
+            batch_node().render(program, sampler_casted, data, source);
+            glEnable(GL_BLEND);
+            fbo_t::unbind();
+            copy_to_backdrop();
+        }
+#endif
+
+    private:
+        template<class buffers_type>
+        void draw_path_buffers(sampler_t & sampler, const buffers_type & buffers,
+                               const mat3f & transform, float opacity, const mat3f & transform_uv,
+                               float u0, float v0, float u1, float v1) {
+            if(buffers.output_vertices.size()==0) return;
+            const auto type_out =
+                    nitrogl::triangles::microtess_indices_type_to_nitrogl(
+                            buffers.output_indices_type);
+            // paths with narrow indices fall back to wide ones, when the vertices overflow them
+            if(buffers.are_indices_wide())
+                drawTriangles(sampler, type_out,
+                              buffers.output_vertices.data(), buffers.output_vertices.size(),
+                              buffers.output_wide_indices.data(), buffers.output_wide_indices.size(),
+                              nullptr, 0, transform, opacity, transform_uv, u0, v0, u1, v1);
+            else
+                drawTriangles(sampler, type_out,
+                              buffers.output_vertices.data(), buffers.output_vertices.size(),
+                              buffers.output_indices.data(), buffers.output_indices.size(),
+                              nullptr, 0, transform, opacity, transform_uv, u0, v0, u1, v1);
+        }
+
+    public:
         /**
-         * Draw a Path Fill
+         * Draw a Path Fill. The tessellation is cached by the path, for large static paths,
+         * tessellate once with `optimize_vertex_cache`, the reordered triangles are re-used here.
          * @tparam path_container_template template of container used by path
          * @tparam tessellation_allocator the path allocator
+         * @tparam path_index the index type of the path, 16 bit indices are drawn as is,
+         *         unless the path fell back to wide indices
          * @param sampler The sampler to sample from
          * @param path The path object
          * @param rule Fill rule { non_zero, even_odd }
@@ -511,9 +1225,9 @@ namespace nitrogl {
          * @param u0/v0/u1/v1 UVs window
          */
         template <template<typename...> class path_container_template,
-                  class tessellation_allocator>
+                  class tessellation_allocator, typename path_index>
         void drawPathFill(const sampler_t & sampler,
-                          microtess::path<float, path_container_template, tessellation_allocator> & path,
+                          microtess::path<float, path_container_template, tessellation_allocator, path_index> & path,
                           const microtess::fill_rule &rule,
                           const microtess::tess_quality &quality,
                           const mat3f & transform = mat3f::identity(),
@@ -522,21 +1236,8 @@ namespace nitrogl {
                           float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             const auto & buffers= path.tessellateFill(rule, quality, false, false);
-            if(buffers.output_vertices.size()==0) return;
-            const auto type_out =
-                    nitrogl::triangles::microtess_indices_type_to_nitrogl(
-                            buffers.output_indices_type);
-
-            drawTriangles(
-                    sampler_casted,
-                    type_out,
-                    buffers.output_vertices.data(), buffers.output_vertices.size(),
-                    buffers.output_indices.data(), buffers.output_indices.size(),
-                    nullptr, 0,
-                    transform,
-                    opacity,
-                    transform_uv,
-                    u0, v0, u1, v1);
+            draw_path_buffers(sampler_casted, buffers, transform, opacity, transform_uv,
+                              u0, v0, u1, v1);
 //            if(debug) {
 //                drawTrianglesWireframe({0,0,0,255}, transform,
 //                                       buffers.output_vertices.data(),
@@ -554,6 +1255,8 @@ namespace nitrogl {
          * @tparam Iterable Any numbers iterable container (implements begin()/)end())
          * @tparam path_container_template template of container used by path
          * @tparam tessellation_allocator the path allocator
+         * @tparam path_index the index type of the path, 16 bit indices are drawn as is,
+         *         unless the path fell back to wide indices
          * @param sampler The sampler to sample from
          * @param path The path object
          * @param stroke_width          stroke width in pixels
@@ -568,9 +1271,9 @@ namespace nitrogl {
          * @param u0/v0/u1/v1 UVs window
          */
         template <class Iterable, template<typename...> class path_container_template,
-                    class tessellation_allocator>
+                    class tessellation_allocator, typename path_index>
         void drawPathStroke(const sampler_t & sampler,
-                          microtess::path<float, path_container_template, tessellation_allocator> & path,
+                          microtess::path<float, path_container_template, tessellation_allocator, path_index> & path,
                           float stroke_width=1.0f,
                           microtess::stroke_cap cap=microtess::stroke_cap::butt,
                           microtess::stroke_line_join line_join=microtess::stroke_line_join::bevel,
@@ -584,21 +1287,8 @@ namespace nitrogl {
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             const auto & buffers= path.template tessellateStroke<Iterable>(
                     stroke_width, cap, line_join, miter_limit, stroke_dash_array, stroke_dash_offset);
-            if(buffers.output_vertices.size()==0) return;
-            const auto type_out =
-                    nitrogl::triangles::microtess_indices_type_to_nitrogl(
-                            buffers.output_indices_type);
-
-            drawTriangles(
-                    sampler_casted,
-                    type_out,
-                    buffers.output_vertices.data(), buffers.output_vertices.size(),
-                    buffers.output_indices.data(), buffers.output_indices.size(),
-                    nullptr, 0,
-                    transform,
-                    opacity,
-                    transform_uv,
-                    u0, v0, u1, v1);
+            draw_path_buffers(sampler_casted, buffers, transform, opacity, transform_uv,
+                              u0, v0, u1, v1);
 //            if(debug)
 //                drawTrianglesWireframe({0, 0, 0, 255}, transform,
 //                                       buffers.output_vertices.data(),
@@ -801,14 +1491,23 @@ namespace nitrogl {
             prepare_uv_transform(transform_uv, right-left, bottom-top,
                                  sampler.intrinsic_width, sampler.intrinsic_height,
                                  u0, v0, u1, v1);
+            const auto derivatives = uv_derivatives(transform, transform_uv, right-left, bottom-top);
+            // make the transform about its origin, a nice feature
+            transform.post_translate(vec2f(left, top)).pre_translate(vec2f(-left, -top));
+            if(_pre_transform_threshold>=4) {
+                const vec2f quad[4] = { {left, bottom}, {right, bottom}, {right, top}, {left, top} };
+                const vec2f quad_uvs[4] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f} };
+                const GLubyte quad_indices[6] = { 0, 1, 2, 2, 3, 0 };
+                if(merge_pre_transformed(sampler_casted, quad, 4, quad_indices, 6, quad_uvs,
+                                         rectf(left, top, right, bottom), transform, transform_uv,
+                                         opacity, derivatives))
+                    return;
+            }
+            derivatives.apply(sampler_casted);
             glViewport(0, 0, GLsizei(width()), GLsizei(height()));
             _fbo.bind();
             // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
-            // make the transform about its origin, a nice feature
-            transform.post_translate(vec2f(left, top)).pre_translate(vec2f(-left, -top));
+            auto mat_proj = projection();
             // buffers
             float puvs[20] = {
                     left,  bottom, 0.0f, 0.0f, 1.0f, // xyuvq
@@ -860,12 +1559,99 @@ namespace nitrogl {
             const auto * current_blend_mode = _blend_mode;
             const auto * current_alpha_compositor = _alpha_compositor;
             update_composition(blend_modes::Normal(), porter_duff::DestinationIn());
+            const internal_sampler_scope internal_scope{*this};
             channel_sampler cs {&sampler_casted, channel};
             drawRect(cs, left, top, right, bottom, 1.0f, transform,
                      u0, v0, u1, v1, transform_uv);
             update_composition(current_blend_mode, current_alpha_compositor);
         }
 
+    private:
+        // upper bound of segments of the tight meshes around circles
+        static constexpr unsigned max_shape_segments = 128;
+
+        /**
+         * Write a polygonal chain, that circumscribes an arc of a circle, so the chain never
+         * cuts into the circle and strays from it by about a pixel at most.
+         * Angles are counter-clockwise with y-axis up, same as the shape samplers.
+         * @param out output vertices, every `stride` vertex is written
+         * @param x/y center in canvas coordinates
+         * @param from start angle
+         * @param angle counter-clockwise angle of the arc
+         * @return the amount of written vertices
+         */
+        static unsigned circumscribe_arc(vec2f * out, unsigned stride, float x, float y,
+                                         float radius, float from, float angle) {
+            // cos(step/2) >= R/(R+1) keeps the chain within a pixel, step ~ 2*sqrt(2/(R+1))
+            float step = 2.0f*math::sqrt(2.0f/(radius + 1.0f));
+            const float max_step = math::pi<float>()/4.0f;
+            step = step>max_step ? max_step : step;
+            unsigned segments = unsigned(angle/step) + 1;
+            segments = segments>max_shape_segments ? max_shape_segments : segments;
+            step = angle/float(segments);
+            const float r = radius/math::cos(step/2.0f);
+            for (unsigned ix = 0; ix <= segments; ++ix) {
+                const float a = from + step*float(ix);
+                out[ix*stride] = vec2f{x + r*math::cos(a), y - r*math::sin(a)};
+            }
+            return segments + 1;
+        }
+
+        /**
+         * counter-clockwise angle from `from` to `to`, same as the shape samplers. equal
+         * angles mean a full circle.
+         */
+        static float ccw_span(float from, float to) {
+            const float two_pi = math::pi<float>()*2.0f;
+            float span = math::mod(to-from, two_pi);
+            if(span<0.0f) span += two_pi;
+            return span==0.0f ? two_pi : span;
+        }
+
+        /**
+         * Draw a tight mesh of a shape sampler, that is stretched on a bounding rectangle.
+         * UVs are generated from the rectangle, so the sampler sees the same UVs as it would with
+         * `drawRect` over the rectangle, but fragments outside the mesh are never shaded.
+         * The intrinsic size of the sampler is ignored, same as shape samplers, which do not
+         * have one, so sub-samplers of a shape may be drawn directly with the same mapping.
+         */
+        void draw_shape_mesh(sampler_t & sampler, enum triangles::indices type,
+                             const vec2f * vertices, index vertices_size,
+                             float left, float top, float right, float bottom,
+                             float opacity, mat3f transform,
+                             float u0, float v0, float u1, float v1, mat3f transform_uv) {
+            prepare_uv_transform(transform_uv, right-left, bottom-top,
+                                 0.0f, 0.0f, u0, v0, u1, v1);
+            update_uv_derivatives(sampler, transform, transform_uv, right-left, bottom-top);
+            glViewport(0, 0, GLsizei(width()), GLsizei(height()));
+            _fbo.bind();
+            // inverted y projection, canvas coords to opengl
+            auto mat_proj = projection();
+            // make the transform about the left-top of the rectangle, same as drawRect
+            transform.post_translate(vec2f(left, top)).pre_translate(vec2f(-left, -top));
+            auto & program = get_main_shader_program_for_sampler(sampler, true);
+            multi_render_node::data_type data = {
+                    vertices, nullptr, nullptr, nullptr,
+                    vertices_size, 0, 0, 0, GL_UNSIGNED_INT,
+                    GLenum(type),
+                    mat4f(transform), // promote it to mat4x4
+                    mat4f::identity(),
+                    mat_proj,
+                    transform_uv,
+                    _tex_backdrop,
+                    width(), height(),
+                    opacity,
+                    rectf(left, top, right, bottom)
+            };
+            glDisable(GL_BLEND);
+            _node_multi.render(program, sampler, data);
+            glEnable(GL_BLEND);
+            fbo_t::unbind();
+            copy_to_backdrop();
+        }
+
+    public:
+
         /**
          * Draw a Circle
          * @param sampler_fill Sampler used for interior
@@ -900,6 +1686,7 @@ namespace nitrogl {
             float aa_fill = 1.0f/w;
             float aa_stroke = stroke_n==0.0f ? 0.0f : (1.f/w);
 
+            const internal_sampler_scope internal_scope{*this};
             circle_sampler cs(&sampler_fill_casted, &sampler_stroke_casted, radius_n,
                               stroke_n, aa_fill, aa_stroke);
 
@@ -908,10 +1695,14 @@ namespace nitrogl {
 //            pad/=2.0f;
             transform_modified.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
 
-            drawRect(cs, l, t, r, b,
-                     opacity,
-                     transform_modified,
-                     u0, v0, u1, v1, transform_uv);
+            // a polygon around the circle, stroke and anti-aliasing instead of the padded square
+            vec2f vertices[max_shape_segments + 2];
+            vertices[0] = vec2f{x, y};
+            const auto count = circumscribe_arc(vertices + 1, 1, x, y, radius + stroke/2.0f + 3.0f,
+                                                0.0f, math::pi<float>()*2.0f);
+            draw_shape_mesh(cs, triangles::indices::TRIANGLES_FAN, vertices, count + 1,
+                            l, t, r, b, opacity, transform_modified,
+                            u0, v0, u1, v1, transform_uv);
         }
 
         /**
@@ -956,6 +1747,7 @@ namespace nitrogl {
             float aa_stroke = stroke_n==0.0f ? 0.0f : (1.0f/w);
             from_angle = nitrogl::math::clamp(from_angle, 0.0f, math::pi<float>()*2.0f);
             to_angle = nitrogl::math::clamp(to_angle, 0.0f, math::pi<float>()*2.0f);
+            const internal_sampler_scope internal_scope{*this};
             arc_sampler cs {&sampler_fill_casted, &sampler_stroke_casted, from_angle, to_angle, radius_n,
                             radius_inner_n, stroke_n, aa_fill, aa_stroke };
             // make the transform about left-top of shape
@@ -963,10 +1755,31 @@ namespace nitrogl {
             //            pad/=2.0f;
             transform_modified.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
 
-            drawRect(cs, l, t, r, b,
-                     opacity,
-                     transform_modified,
-                     u0, v0, u1, v1, transform_uv);
+            // an annular strip around the arc, it's width, stroke and anti-aliasing
+            const float pi = math::pi<float>();
+            const float e = inner_radius + stroke/2.0f + 3.0f;
+            vec2f vertices[(max_shape_segments + 2)*2];
+            if(radius<=e*1.5f) { // thick arcs cover the center
+                vertices[0] = vec2f{x, y};
+                const auto count = circumscribe_arc(vertices + 1, 1, x, y, radius + e, 0.0f, pi*2.0f);
+                draw_shape_mesh(cs, triangles::indices::TRIANGLES_FAN, vertices, count + 1,
+                                l, t, r, b, opacity, transform_modified,
+                                u0, v0, u1, v1, transform_uv);
+                return;
+            }
+            // the round caps extend the angles by asin(e/radius) <= (pi/2)*(e/radius)
+            const float cap = (pi/2.0f)*(e/radius);
+            float from = from_angle - cap, angle = ccw_span(from_angle, to_angle) + cap*2.0f;
+            if(angle>=pi*2.0f) { from = 0.0f; angle = pi*2.0f; }
+            const auto count = circumscribe_arc(vertices, 2, x, y, radius + e, from, angle);
+            const float step = angle/float(count - 1), r_in = radius - e;
+            for (unsigned ix = 0; ix < count; ++ix) { // inscribed chain is inside the inner circle
+                const float a = from + step*float(ix);
+                vertices[ix*2 + 1] = vec2f{x + r_in*math::cos(a), y - r_in*math::sin(a)};
+            }
+            draw_shape_mesh(cs, triangles::indices::TRIANGLES_STRIP, vertices, count*2,
+                            l, t, r, b, opacity, transform_modified,
+                            u0, v0, u1, v1, transform_uv);
         }
 
         /**
@@ -1008,6 +1821,7 @@ namespace nitrogl {
             float aa_stroke = stroke_n==0.0f ? 0.0f : (1.0f/w);
 //            from_angle = nitrogl::math::clamp(from_angle, 0.0f, math::pi<float>()*2.0f);
 //            to_angle = nitrogl::math::clamp(to_angle, 0.0f, math::pi<float>()*2.0f);
+            const internal_sampler_scope internal_scope{*this};
             pie_sampler cs {&sampler_fill_casted, &sampler_stroke_casted, from_angle, to_angle, radius_n,
                             stroke_n, aa_fill, aa_stroke };
             // make the transform about left-top of shape
@@ -1015,10 +1829,34 @@ namespace nitrogl {
             //            pad/=2.0f;
             transform_modified.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
 
-            drawRect(cs, l, t, r, b,
-                     opacity,
-                     transform_modified,
-                     u0, v0, u1, v1, transform_uv);
+            // a wedge around the pie, stroke and anti-aliasing. The wedge is the intersection of
+            // the sides, pushed out by e, a bevel at distance e behind the apex and the circle.
+            const float pi = math::pi<float>();
+            const float e = stroke/2.0f + 3.0f, R = radius + e;
+            const float span = ccw_span(from_angle, to_angle);
+            // the pushed out sides meet the circle at most asin(e/R) <= (pi/2)*(e/R) outside
+            const float side = (pi/2.0f)*(e/R);
+            vec2f vertices[max_shape_segments + 3];
+            if(span + side*2.0f > pi*0.9f) { // reflex or almost, use a polygon around the circle
+                vertices[0] = vec2f{x, y};
+                const auto count = circumscribe_arc(vertices + 1, 1, x, y, R, 0.0f, pi*2.0f);
+                draw_shape_mesh(cs, triangles::indices::TRIANGLES_FAN, vertices, count + 1,
+                                l, t, r, b, opacity, transform_modified,
+                                u0, v0, u1, v1, transform_uv);
+                return;
+            }
+            const float half = span/2.0f, mid = from_angle + half;
+            const float s = e*(1.0f - math::sin(half))/math::cos(half);
+            // bevel corners at -e*m -+ s*m_perp, m is the bisector, y-axis is flipped
+            const float mx = math::cos(mid), my = -math::sin(mid);
+            const float px = math::sin(mid), py = math::cos(mid); // m_perp = (-sin, cos) flipped
+            vertices[0] = vec2f{x - e*mx + s*px, y - e*my + s*py};
+            const auto count = circumscribe_arc(vertices + 1, 1, x, y, R, from_angle - side,
+                                                span + side*2.0f);
+            vertices[count + 1] = vec2f{x - e*mx - s*px, y - e*my - s*py};
+            draw_shape_mesh(cs, triangles::indices::TRIANGLES_FAN, vertices, count + 2,
+                            l, t, r, b, opacity, transform_modified,
+                            u0, v0, u1, v1, transform_uv);
         }
 
         /**
@@ -1083,8 +1921,7 @@ namespace nitrogl {
             glViewport(0, 0, width(), height());
             _fbo.bind();
             // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0, -1, 1);
+            auto mat_proj = projection();
             // make the transform about it's origin, a nice feature
             transform.post_translate(vec2f(v0_x, v0_y)).pre_translate(vec2f(-v0_x, -v0_y));
             // buffers
@@ -1156,6 +1993,7 @@ namespace nitrogl {
             float stroke_n = stroke/max_d;
             float aa_fill = 1.0f/max_d;
             float aa_stroke = stroke_n==0.0f ? 0.0f : (1.0f/max_d);
+            const internal_sampler_scope internal_scope{*this};
             rounded_rect_sampler cs(&sampler_fill_casted, &sampler_stroke_casted, w, h,
                                     radius_n, stroke_n, aa_fill, aa_stroke);
 
@@ -1164,37 +2002,59 @@ namespace nitrogl {
             transform_modified.post_translate(vec2f(off_l, off_t))
                               .pre_translate(vec2f(-off_l, -off_t));
 
-            drawRect(cs,
-                     l_c, t_c, l_c + max_d, t_c + max_d,
-                     opacity, transform_modified,
-                     u0, v0, u1, v1, transform_uv);
+            // nine slice, the SDF is only evaluated on a frame of width k inside the rectangle
+            // and the corners. Deeper inside, the shape is exactly the fill sampler. A custom
+            // uv mapping moves the shape inside the rectangle, so it draws the whole SDF.
+            const float k = stroke/2.0f + 3.0f; // stroke and anti-aliasing
+            const float c = radius>k ? radius : k; // corners
+            const bool is_uv_mapped = u0!=0.0f || v0!=0.0f || u1!=1.0f || v1!=1.0f ||
+                                      !(transform_uv==mat3f::identity());
+            if(is_uv_mapped || right-left<=c*2.0f || bottom-top<=c*2.0f) {
+                drawRect(cs,
+                         l_c, t_c, l_c + max_d, t_c + max_d,
+                         opacity, transform_modified,
+                         u0, v0, u1, v1, transform_uv);
+                return;
+            }
+            // a 5x5 grid of cells, that share vertices, so there are no t-junctions and cracks
+            const float xs[6] = { left-k, left+k, left+c, right-c, right-k, right+k };
+            const float ys[6] = { top-k, top+k, top+c, bottom-c, bottom-k, bottom+k };
+            vec2f sdf_vertices[25*6], fill_vertices[5*6];
+            index sdf_size = 0, fill_size = 0;
+            for (unsigned j = 0; j < 5; ++j) {
+                for (unsigned i = 0; i < 5; ++i) {
+                    if(xs[i]>=xs[i+1] || ys[j]>=ys[j+1]) continue; // corners are empty if c==k
+                    const bool is_fill = (i==2 && j>=1 && j<=3) || (j==2 && i>=1 && i<=3);
+                    vec2f * out = is_fill ? fill_vertices : sdf_vertices;
+                    index & n = is_fill ? fill_size : sdf_size;
+                    out[n++] = vec2f{xs[i], ys[j]}; out[n++] = vec2f{xs[i+1], ys[j]};
+                    out[n++] = vec2f{xs[i+1], ys[j+1]}; out[n++] = vec2f{xs[i], ys[j]};
+                    out[n++] = vec2f{xs[i+1], ys[j+1]}; out[n++] = vec2f{xs[i], ys[j+1]};
+                }
+            }
+            draw_shape_mesh(cs, triangles::indices::TRIANGLES, sdf_vertices, sdf_size,
+                            l_c, t_c, l_c + max_d, t_c + max_d, opacity, transform_modified,
+                            u0, v0, u1, v1, transform_uv);
+            draw_shape_mesh(sampler_fill_casted, triangles::indices::TRIANGLES,
+                            fill_vertices, fill_size,
+                            l_c, t_c, l_c + max_d, t_c + max_d, opacity, transform_modified,
+                            u0, v0, u1, v1, transform_uv);
         }
 
+    private:
         /**
-         * Draw text based on a regular bitmap font
-         * @tparam max_chars max amount of chars in the bitmap font
-         * @tparam Allocator memory allocator
-         * @param text null terminated char array
-         * @param font Bitmap font
-         * @param color tint color
-         * @param format text format
-         * @param left pos left
-         * @param top pos top
-         * @param right pos right
-         * @param bottom pos bottom
-         * @param transform transform matrix
-         * @param opacity opacity
-         * @param allocator allocator reference
+         * layout text, tessellate the glyphs quads and draw them with a sampler
+         * @param fractional_scale scale glyphs by the exact font scale, otherwise by
+         *                         whole multiples, that keep bitmap glyphs crisp
          */
-        template<unsigned max_chars, class Allocator=nitrogl::std_rebind_allocator<>>
-        void drawText(const char * text,
-                      const nitrogl::text::bitmap_font<max_chars> & font,
-                      const color_t & color,
-                      nitrogl::text::text_format & format,
-                      int left, int top, int right, int bottom,
-                      mat3f transform = mat3f::identity(),
-                      float opacity=1.0f,
-                      const Allocator & allocator=Allocator()) {
+        template<unsigned max_chars, class Allocator>
+        void draw_text_internal(const char * text,
+                                const nitrogl::text::bitmap_font<max_chars> & font,
+                                const sampler_t & sampler,
+                                nitrogl::text::text_format & format,
+                                int left, int top, int right, int bottom,
+                                const mat3f & transform, float opacity,
+                                const Allocator & allocator, bool fractional_scale) {
             auto old=clipRect(); updateClipRect(left, top, right, bottom);
             unsigned int text_size=0;
             { const char * iter=text; while(*iter++!= '\0' && ++text_size); }
@@ -1216,10 +2076,9 @@ namespace nitrogl {
             const auto result=font.layout_text(text, text_size, right-left,
                                                bottom-top, format, char_loc_buffer);
             unsigned layout_size= result.end_index;
-            const int P=result.precision, S=(result.scale)/(1<<P);
-            const bool has_scaled=S!=1<<P;
-
-            auto blah = sizeof (nitrogl::text::char_location);
+            const int P=result.precision;
+            const float S = fractional_scale ? float(result.scale)/float(1<<P)
+                                             : float((result.scale)/(1<<P));
 
             // allocate render buffers
             const auto indices_size = layout_size * 6;
@@ -1276,13 +2135,8 @@ namespace nitrogl {
                 }
             }
 
-            // setup text sampler
-            texture_sampler tex {font.bitmap, false};
-            tint_sampler tint { color, &tex };
-            //drawRect(tex, 100, 100, 400,  400);
-
             // draw interleaved triangles
-            drawInterleavedTriangles(tint,
+            drawInterleavedTriangles(sampler,
                                      type,
                                      xyuvs, xyuvs_size,
                                      indices, indices_size,
@@ -1296,6 +2150,79 @@ namespace nitrogl {
             float_allocator.deallocate(xyuvs);
         }
 
+    public:
+        /**
+         * Draw text based on a regular bitmap font
+         * @tparam max_chars max amount of chars in the bitmap font
+         * @tparam Allocator memory allocator
+         * @param text null terminated char array
+         * @param font Bitmap font
+         * @param color tint color
+         * @param format text format
+         * @param left pos left
+         * @param top pos top
+         * @param right pos right
+         * @param bottom pos bottom
+         * @param transform transform matrix
+         * @param opacity opacity
+         * @param allocator allocator reference
+         */
+        template<unsigned max_chars, class Allocator=nitrogl::std_rebind_allocator<>>
+        void drawText(const char * text,
+                      const nitrogl::text::bitmap_font<max_chars> & font,
+                      const color_t & color,
+                      nitrogl::text::text_format & format,
+                      int left, int top, int right, int bottom,
+                      mat3f transform = mat3f::identity(),
+                      float opacity=1.0f,
+                      const Allocator & allocator=Allocator()) {
+            // setup text sampler
+            const internal_sampler_scope internal_scope{*this};
+            texture_sampler tex {font.bitmap, false};
+            tint_sampler tint { color, &tex };
+            draw_text_internal(text, font, tint, format, left, top, right, bottom,
+                               transform, opacity, allocator, false);
+        }
+
+        /**
+         * Draw text based on a signed distance field font. A single atlas serves all the
+         * sizes and transforms, coverage is computed in the fragment shader.
+         * @tparam max_chars max amount of chars in the font
+         * @tparam Allocator memory allocator
+         * @param text null terminated char array
+         * @param font signed distance field font
+         * @param color text color
+         * @param format text format
+         * @param left pos left
+         * @param top pos top
+         * @param right pos right
+         * @param bottom pos bottom
+         * @param transform transform matrix
+         * @param opacity opacity
+         * @param allocator allocator reference
+         */
+        template<unsigned max_chars, class Allocator=nitrogl::std_rebind_allocator<>>
+        void drawText(const char * text,
+                      const nitrogl::text::sdf_font<max_chars> & font,
+                      const color_t & color,
+                      nitrogl::text::text_format & format,
+                      int left, int top, int right, int bottom,
+                      mat3f transform = mat3f::identity(),
+                      float opacity=1.0f,
+                      const Allocator & allocator=Allocator()) {
+            // distance range in screen pixels = range x glyph scale x transform scale
+            const float font_scale = (format.fontSize<0 || font.nativeSize<=0) ? 1.0f :
+                                     float(format.fontSize)/float(font.nativeSize);
+            const float det = transform(0,0)*transform(1,1) - transform(0,1)*transform(1,0);
+            const float transform_scale = nitrogl::math::sqrt(det<0.0f ? -det : det);
+            const internal_sampler_scope internal_scope{*this};
+            sdf_text_sampler sampler {font.bitmap, color, font.multiChannel, font.channel,
+                                      font.distanceRange*font_scale*transform_scale};
+            draw_text_internal(text, font, sampler, format, left, top, right, bottom,
+                               transform, opacity, allocator, true);
+        }
+
+
         /**
          * Draw a simple 1 pixel width lines path
          * @param sampler Sampler reference
@@ -1323,23 +2250,22 @@ namespace nitrogl {
             prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
                                  sampler.intrinsic_width, sampler.intrinsic_height,
                                  u0, v0, u1, v1);
+            update_uv_derivatives(sampler_casted, transform, transform_uv, bbox.width(), bbox.height());
 
             //
             glViewport(0, 0, GLsizei(width()), GLsizei(height()));
             _fbo.bind();
             // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
+            auto mat_proj = projection();
             // make the transform about its origin, a nice feature
             transform.post_translate(vec2f(-bbox.left, -bbox.top)).pre_translate(vec2f(bbox.left, bbox.top));
             // buffers
-            auto & program = get_main_shader_program_for_sampler(sampler_casted);
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, true);
             // data
             const auto type = closed_path ? nitrogl::triangles::LINE_LOOP : nitrogl::triangles::LINE_STRIP;
             multi_render_node::data_type data = {
                     points, nullptr, nullptr, nullptr,
-                    size, 0, 0, 0,
+                    size, 0, 0, 0, GL_UNSIGNED_INT,
                     GLenum(type),
                     mat4f(transform), // promote it to mat4x4
                     mat4f::identity(),
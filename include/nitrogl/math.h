@@ -25,6 +25,7 @@
 #include "math/vertex2.h"
 #include "math/vertex3.h"
 #include "math/vertex4.h"
+#include "math/vec2_kernels.h"
 
 namespace nitrogl {
     namespace math {
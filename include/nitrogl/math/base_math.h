@@ -82,5 +82,17 @@ namespace nitrogl {
         number tan_bhaskara_cpu(number radians) {
             return sin_bhaskara_cpu<number>(radians)/cos_bhaskara_cpu<number>(radians);
         }
+
+        /**
+         * integer part and a quadratic fit of the mantissa, about 3 decimals
+         */
+        template<typename number>
+        number log2_cpu(number val) {
+            if(val<=number(0)) return number(-128);
+            number e = number(0);
+            while(val>=number(2)) { val/=number(2); e+=number(1); }
+            while(val<number(1)) { val*=number(2); e-=number(1); }
+            return e + (number(-0.34484843)*val + number(2.02466578))*val - number(1.67487759);
+        }
     };
 }
\ No newline at end of file
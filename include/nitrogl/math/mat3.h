@@ -24,6 +24,7 @@ namespace nitrogl {
         // in this derived class I overload * operator, this will default in
         // c++ to hiding all previous * overloading, so we have to re-expose it
         using base__::operator*;
+        using base__::operator*=;
         using value_type = number;
         using index = unsigned;
         using type_ref = number &;
@@ -131,8 +132,33 @@ namespace nitrogl {
         mat3(const matrix<T2, 3, 3, column_major> & mat) : base__(mat) {}
         virtual ~mat3() = default;
 
+        /**
+         * multiplication of affine matrices into result, the projective row (0, 0, 1) is
+         * skipped. result is written in place, it may be a (but not b).
+         */
+        static void multiply_affine(const mat3 & a, const mat3 & b, mat3 & result) {
+            if(column_major) {
+                base__::multiply_affine_3x3_column_major(a.data(), b.data(), result.data());
+                return;
+            }
+            // the projective row of row major data is a column, so it takes the unrolled path
+            number temp[9];
+            base__::multiply_3x3_column_major(b.data(), a.data(), temp);
+            for (index ix = 0; ix < 9; ++ix) result[ix] = temp[ix];
+        }
+
         mat3 operator*(const mat3 &  value) const {
-            return base__::operator*(value);
+            return mat3(base__::multiply(*this, value));
+        };
+        /**
+         * multiplies in place. affine matrices (most transforms) take the affine path,
+         * without the temporaries of *this = (*this) * value
+         */
+        mat3 & operator*=(const mat3 &  value) {
+            if(&value!=this && isAffine() && value.isAffine())
+                multiply_affine(*this, value, *this);
+            else *this = (*this) * value;
+            return *this;
         };
 
         template<class vertex>
@@ -158,6 +184,15 @@ namespace nitrogl {
             return *this;
         }
 
+        /**
+         * the last row is (0, 0, 1)
+         */
+        bool isAffine() const {
+            constexpr bool c = column_major;
+            const auto & m = (*this);
+            return m[c?2:6]==number(0) && m[c?5:7]==number(0) && m[8]==number(1);
+        }
+
         bool isIdentity() const {
             number zero=number{0}, one{1};
             return (
@@ -26,6 +26,7 @@ namespace nitrogl {
         // in this derived class I overload * operator, this will default in
         // c++ to hiding all previous * overloading, so we have to re-expose it
         using base__::operator*;
+        using base__::operator*=;
         using index = unsigned;
         using value_type = number;
         using type_ref = number &;
@@ -131,13 +132,20 @@ namespace nitrogl {
         mat4(const base__ & mat) : base__(mat) {}
         template<typename number2>
         mat4(const matrix<number2, 4, 4, column_major> & mat) : base__(mat) {}
+        /**
+         * promote a 3x3 matrix into the top-left block, the rest is identity.
+         * the elements are written once, in place
+         */
         template<typename number2>
         mat4(const mat3<number2> & mat) : base__() {
-            fill_identity();
-            // todo:: optimize this to avoid (r,c) indexing = without multiplication
-            for (int ix = 0; ix < 3; ++ix)
-                for (int jx = 0; jx < 3; ++jx)
-                    this->operator()(ix, jx) = mat(ix, jx);
+            constexpr bool c = column_major;
+            const number zero{0}, one{1};
+            auto & m = *this;
+            m[0] = number(mat(0,0)); m[c?1:4] = number(mat(1,0)); m[c?2:8] = number(mat(2,0));
+            m[c?4:1] = number(mat(0,1)); m[5] = number(mat(1,1)); m[c?6:9] = number(mat(2,1));
+            m[c?8:2] = number(mat(0,2)); m[c?9:6] = number(mat(1,2)); m[10] = number(mat(2,2));
+            m[c?3:12]=zero; m[c?7:13]=zero; m[c?11:14]=zero; // 4th row
+            m[c?12:3]=zero; m[c?13:7]=zero; m[c?14:11]=zero; m[15]=one; // 4th column
         }
         virtual ~mat4() = default;
 
@@ -164,6 +172,30 @@ namespace nitrogl {
             me(row,0)=val.x; me(row,1)=val.y; me(row,2)=val.z;
         }
 
+        /**
+         * unrolled multiplication. an affine only path (skipping the projective row) is not
+         * faster for 4x4, because the unrolled columns vectorize well.
+         */
+        mat4 operator*(const mat4 & value) const {
+            return mat4(base__::multiply(*this, value));
+        }
+        /**
+         * multiplies in place, without the temporaries of *this = (*this) * value
+         */
+        mat4 & operator*=(const mat4 & value) {
+            if(column_major && &value!=this)
+                base__::multiply_4x4_column_major(this->data(), value.data(), this->data());
+            else *this = (*this) * value;
+            return *this;
+        }
+
+        bool isAffine() const {
+            constexpr bool c = column_major;
+            const auto & m = (*this);
+            return m[c?3:12]==number(0) && m[c?7:13]==number(0) &&
+                   m[c?11:14]==number(0) && m[15]==number(1);
+        }
+
         vertex4 operator*(const vertex4 & point) const {
             constexpr bool c = column_major; // much faster
             vertex4 res;
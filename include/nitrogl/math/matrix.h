@@ -93,6 +93,79 @@ namespace nitrogl {
             return m3;
         }
 
+        /**
+         * unrolled 3x3 multiplication, it is more specialized than the generic multiplication,
+         * so it is selected for 3x3 operands of the same layout
+         */
+        template<bool cm>
+        static matrix<number, 3, 3, cm> multiply(const matrix<number, 3, 3, cm> & m1,
+                                                 const matrix<number, 3, 3, cm> & m2) {
+            matrix<number, 3, 3, cm> m3;
+            // row major data is the transpose of column major data, and (A*B)^T = B^T * A^T
+            if(cm) multiply_3x3_column_major(m1.data(), m2.data(), m3.data());
+            else multiply_3x3_column_major(m2.data(), m1.data(), m3.data());
+            return m3;
+        }
+
+        /**
+         * unrolled 4x4 multiplication, see the 3x3 multiplication
+         */
+        template<bool cm>
+        static matrix<number, 4, 4, cm> multiply(const matrix<number, 4, 4, cm> & m1,
+                                                 const matrix<number, 4, 4, cm> & m2) {
+            matrix<number, 4, 4, cm> m3;
+            if(cm) multiply_4x4_column_major(m1.data(), m2.data(), m3.data());
+            else multiply_4x4_column_major(m2.data(), m1.data(), m3.data());
+            return m3;
+        }
+
+        /**
+         * c = a*b of column major 3x3 arrays, c may alias a (it is read up front) but not b.
+         * the sums are in the order of the generic multiplication, so results are identical
+         */
+        static void multiply_3x3_column_major(const number * a, const number * b, number * c) {
+            const number a00=a[0], a10=a[1], a20=a[2];
+            const number a01=a[3], a11=a[4], a21=a[5];
+            const number a02=a[6], a12=a[7], a22=a[8];
+            c[0] = a00*b[0] + a01*b[1] + a02*b[2];
+            c[1] = a10*b[0] + a11*b[1] + a12*b[2];
+            c[2] = a20*b[0] + a21*b[1] + a22*b[2];
+            c[3] = a00*b[3] + a01*b[4] + a02*b[5];
+            c[4] = a10*b[3] + a11*b[4] + a12*b[5];
+            c[5] = a20*b[3] + a21*b[4] + a22*b[5];
+            c[6] = a00*b[6] + a01*b[7] + a02*b[8];
+            c[7] = a10*b[6] + a11*b[7] + a12*b[8];
+            c[8] = a20*b[6] + a21*b[7] + a22*b[8];
+        }
+
+        /**
+         * c = a*b of column major 4x4 arrays, c may alias a but not b.
+         */
+        static void multiply_4x4_column_major(const number * a, const number * b, number * c) {
+            const number a00=a[0], a10=a[1], a20=a[2], a30=a[3];
+            const number a01=a[4], a11=a[5], a21=a[6], a31=a[7];
+            const number a02=a[8], a12=a[9], a22=a[10], a32=a[11];
+            const number a03=a[12], a13=a[13], a23=a[14], a33=a[15];
+            for (index col = 0; col < 16; col+=4) {
+                const number b0=b[col], b1=b[col+1], b2=b[col+2], b3=b[col+3];
+                c[col]   = a00*b0 + a01*b1 + a02*b2 + a03*b3;
+                c[col+1] = a10*b0 + a11*b1 + a12*b2 + a13*b3;
+                c[col+2] = a20*b0 + a21*b1 + a22*b2 + a23*b3;
+                c[col+3] = a30*b0 + a31*b1 + a32*b2 + a33*b3;
+            }
+        }
+
+        /**
+         * c = a*b of column major affine 3x3 arrays (last row is (0, 0, 1)), the projective
+         * row is skipped. c may alias a but not b.
+         */
+        static void multiply_affine_3x3_column_major(const number * a, const number * b, number * c) {
+            const number a00=a[0], a10=a[1], a01=a[3], a11=a[4], a02=a[6], a12=a[7];
+            c[0] = a00*b[0] + a01*b[1]; c[1] = a10*b[0] + a11*b[1]; c[2] = number(0);
+            c[3] = a00*b[3] + a01*b[4]; c[4] = a10*b[3] + a11*b[4]; c[5] = number(0);
+            c[6] = a00*b[6] + a01*b[7] + a02; c[7] = a10*b[6] + a11*b[7] + a12; c[8] = number(1);
+        }
+
         template<unsigned A, unsigned B, unsigned C>
         static matrix<number, C, B> multiply3232323(
                 const matrix<number, A, B> & m1,
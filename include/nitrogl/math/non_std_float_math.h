@@ -35,5 +35,7 @@ namespace nitrogl {
         inline double cos(const double radians) { return nitrogl::math::cos_bhaskara_cpu<double>(radians); }
         inline float tan(const float radians) { return nitrogl::math::tan_bhaskara_cpu<float>(radians); }
         inline double tan(const double radians) { return nitrogl::math::tan_bhaskara_cpu<double>(radians); }
+        inline float log2(const float val) { return nitrogl::math::log2_cpu<float>(val); }
+        inline double log2(const double val) { return nitrogl::math::log2_cpu<double>(val); }
     }
 }
\ No newline at end of file
@@ -40,5 +40,7 @@ namespace nitrogl {
         inline double cos(const double radians) { return std::cos(radians); }
         inline float tan(const float radians) { return std::tan(radians); }
         inline double tan(const double radians) { return std::tan(radians); }
+        inline float log2(const float val) { return std::log2(val); }
+        inline double log2(const double val) { return std::log2(val); }
     }
 }
\ No newline at end of file
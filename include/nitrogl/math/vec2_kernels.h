@@ -0,0 +1,279 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "mat3.h"
+#include "rect.h"
+#include "vertex2.h"
+
+// select the kernels by the instruction sets, that the compiler targets.
+// define NITROGL_DISABLE_SIMD to use the scalar kernels
+#ifndef NITROGL_DISABLE_SIMD
+    #if defined(__AVX2__)
+        #define NITROGL_SIMD_AVX2
+    #endif
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+        #define NITROGL_SIMD_SSE2
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define NITROGL_SIMD_NEON
+    #endif
+#endif
+
+#if defined(NITROGL_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(NITROGL_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(NITROGL_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Kernels over arrays of vec2f, with SSE2/AVX2/NEON paths and a scalar fallback.
+     * Bounding boxes are identical to the scalar kernels, transforms are identical as well,
+     * unless the compiler contracts the scalar multiply-adds into fma instructions.
+     */
+    namespace vec2_kernels {
+        using size_type = unsigned long;
+
+        /**
+         * scalar kernels, also used for the remainders of the simd kernels
+         */
+        namespace scalar {
+            inline void bbox_accumulate(const vec2f & p, float & l, float & t, float & r, float & b) {
+                l = p.x<l ? p.x : l; t = p.y<t ? p.y : t;
+                r = p.x>r ? p.x : r; b = p.y>b ? p.y : b;
+            }
+
+            inline rectf bbox(const vec2f * points, size_type count) {
+                if(count==0) return rectf{};
+                float l=points[0].x, t=points[0].y, r=l, b=t;
+                for (size_type ix = 1; ix < count; ++ix)
+                    bbox_accumulate(points[ix], l, t, r, b);
+                return rectf{l, t, r, b};
+            }
+
+            template<class index_type>
+            rectf bbox(const vec2f * points, const index_type * indices, size_type count) {
+                if(count==0) return rectf{};
+                const auto & first = points[indices[0]];
+                float l=first.x, t=first.y, r=l, b=t;
+                for (size_type ix = 1; ix < count; ++ix)
+                    bbox_accumulate(points[indices[ix]], l, t, r, b);
+                return rectf{l, t, r, b};
+            }
+
+            inline void transform(const mat3f & m, const vec2f * src, vec2f * dst, size_type count) {
+                const float a=m(0,0), b=m(0,1), c=m(0,2), d=m(1,0), e=m(1,1), f=m(1,2);
+                for (size_type ix = 0; ix < count; ++ix) {
+                    const float x = src[ix].x, y = src[ix].y;
+                    dst[ix].x = a*x + b*y + c;
+                    dst[ix].y = d*x + e*y + f;
+                }
+            }
+        }
+
+#if defined(NITROGL_SIMD_SSE2)
+        namespace sse2 {
+            // lanes are {x, y, x, y}, reduce them into the rect
+            inline rectf reduce(__m128 min, __m128 max) {
+                min = _mm_min_ps(min, _mm_movehl_ps(min, min));
+                max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+                float lo[4], hi[4];
+                _mm_storeu_ps(lo, min); _mm_storeu_ps(hi, max);
+                return rectf{lo[0], lo[1], hi[0], hi[1]};
+            }
+            inline __m128 load_two(const vec2f & p0, const vec2f & p1) {
+                const __m128 lo = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(&p0)));
+                return _mm_castpd_ps(_mm_loadh_pd(_mm_castps_pd(lo),
+                                                  reinterpret_cast<const double *>(&p1)));
+            }
+        }
+#endif
+
+        /**
+         * bounding box of points
+         */
+        inline rectf bbox(const vec2f * points, size_type count) {
+#if defined(NITROGL_SIMD_AVX2) || defined(NITROGL_SIMD_SSE2)
+            if(count<2) return scalar::bbox(points, count);
+            const float * f = reinterpret_cast<const float *>(points);
+            // seed every lane with the first point, so remainders are free
+            __m128 min = sse2::load_two(points[0], points[0]), max = min;
+            size_type ix = 0;
+#if defined(NITROGL_SIMD_AVX2)
+            __m256 min8 = _mm256_set_m128(min, min), max8 = min8;
+            for (; ix + 4 <= count; ix+=4) {
+                const __m256 v = _mm256_loadu_ps(f + ix*2);
+                min8 = _mm256_min_ps(min8, v); max8 = _mm256_max_ps(max8, v);
+            }
+            min = _mm_min_ps(_mm256_castps256_ps128(min8), _mm256_extractf128_ps(min8, 1));
+            max = _mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1));
+#endif
+            for (; ix + 2 <= count; ix+=2) {
+                const __m128 v = _mm_loadu_ps(f + ix*2);
+                min = _mm_min_ps(min, v); max = _mm_max_ps(max, v);
+            }
+            if(ix<count) {
+                const __m128 v = sse2::load_two(points[ix], points[ix]);
+                min = _mm_min_ps(min, v); max = _mm_max_ps(max, v);
+            }
+            return sse2::reduce(min, max);
+#elif defined(NITROGL_SIMD_NEON)
+            if(count<4) return scalar::bbox(points, count);
+            const float * f = reinterpret_cast<const float *>(points);
+            float32x4x2_t v = vld2q_f32(f);
+            float32x4_t min_x = v.val[0], max_x = v.val[0], min_y = v.val[1], max_y = v.val[1];
+            size_type ix = 4;
+            for (; ix + 4 <= count; ix+=4) {
+                v = vld2q_f32(f + ix*2);
+                min_x = vminq_f32(min_x, v.val[0]); max_x = vmaxq_f32(max_x, v.val[0]);
+                min_y = vminq_f32(min_y, v.val[1]); max_y = vmaxq_f32(max_y, v.val[1]);
+            }
+            float32x2_t lx = vpmin_f32(vget_low_f32(min_x), vget_high_f32(min_x));
+            float32x2_t ly = vpmin_f32(vget_low_f32(min_y), vget_high_f32(min_y));
+            float32x2_t hx = vpmax_f32(vget_low_f32(max_x), vget_high_f32(max_x));
+            float32x2_t hy = vpmax_f32(vget_low_f32(max_y), vget_high_f32(max_y));
+            float l = vget_lane_f32(vpmin_f32(lx, lx), 0), t = vget_lane_f32(vpmin_f32(ly, ly), 0);
+            float r = vget_lane_f32(vpmax_f32(hx, hx), 0), b = vget_lane_f32(vpmax_f32(hy, hy), 0);
+            for (; ix < count; ++ix) scalar::bbox_accumulate(points[ix], l, t, r, b);
+            return rectf{l, t, r, b};
+#else
+            return scalar::bbox(points, count);
+#endif
+        }
+
+        /**
+         * bounding box of indexed points
+         */
+        template<class index_type>
+        rectf bbox(const vec2f * points, const index_type * indices, size_type count) {
+#if defined(NITROGL_SIMD_AVX2) || defined(NITROGL_SIMD_SSE2)
+            if(count<2) return scalar::bbox(points, indices, count);
+            __m128 min = sse2::load_two(points[indices[0]], points[indices[0]]), max = min;
+            size_type ix = 0;
+            for (; ix + 2 <= count; ix+=2) {
+                const __m128 v = sse2::load_two(points[indices[ix]], points[indices[ix+1]]);
+                min = _mm_min_ps(min, v); max = _mm_max_ps(max, v);
+            }
+            if(ix<count) {
+                const __m128 v = sse2::load_two(points[indices[ix]], points[indices[ix]]);
+                min = _mm_min_ps(min, v); max = _mm_max_ps(max, v);
+            }
+            return sse2::reduce(min, max);
+#elif defined(NITROGL_SIMD_NEON)
+            if(count<2) return scalar::bbox(points, indices, count);
+            const float * f = reinterpret_cast<const float *>(points);
+            float32x4_t min = vcombine_f32(vld1_f32(f + indices[0]*2), vld1_f32(f + indices[0]*2));
+            float32x4_t max = min;
+            size_type ix = 0;
+            for (; ix + 2 <= count; ix+=2) {
+                const float32x4_t v = vcombine_f32(vld1_f32(f + indices[ix]*2),
+                                                   vld1_f32(f + indices[ix+1]*2));
+                min = vminq_f32(min, v); max = vmaxq_f32(max, v);
+            }
+            const float32x2_t lo = vmin_f32(vget_low_f32(min), vget_high_f32(min));
+            const float32x2_t hi = vmax_f32(vget_low_f32(max), vget_high_f32(max));
+            float l = vget_lane_f32(lo, 0), t = vget_lane_f32(lo, 1);
+            float r = vget_lane_f32(hi, 0), b = vget_lane_f32(hi, 1);
+            if(ix<count) scalar::bbox_accumulate(points[indices[ix]], l, t, r, b);
+            return rectf{l, t, r, b};
+#else
+            return scalar::bbox(points, indices, count);
+#endif
+        }
+
+#if defined(NITROGL_SIMD_AVX2)
+        /**
+         * bounding box of 32 bit indexed points, gathers four points at a time
+         */
+        inline rectf bbox(const vec2f * points, const unsigned int * indices, size_type count) {
+            if(count<4) return bbox<unsigned int>(points, indices, count);
+            // a point is 8 bytes, so gather it as a double
+            const double * base = reinterpret_cast<const double *>(points);
+            const __m128 first = sse2::load_two(points[indices[0]], points[indices[0]]);
+            __m256 min = _mm256_set_m128(first, first), max = min;
+            // masked gather with a zeroed source and a full mask, so the destination does not
+            // depend on a stale register
+            const __m256d zero = _mm256_setzero_pd();
+            const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            size_type ix = 0;
+            for (; ix + 4 <= count; ix+=4) {
+                const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + ix));
+                const __m256 v = _mm256_castpd_ps(_mm256_mask_i32gather_pd(zero, base, idx, all, 8));
+                min = _mm256_min_ps(min, v); max = _mm256_max_ps(max, v);
+            }
+            __m128 min4 = _mm_min_ps(_mm256_castps256_ps128(min), _mm256_extractf128_ps(min, 1));
+            __m128 max4 = _mm_max_ps(_mm256_castps256_ps128(max), _mm256_extractf128_ps(max, 1));
+            for (; ix < count; ++ix) {
+                const __m128 v = sse2::load_two(points[indices[ix]], points[indices[ix]]);
+                min4 = _mm_min_ps(min4, v); max4 = _mm_max_ps(max4, v);
+            }
+            return sse2::reduce(min4, max4);
+        }
+#endif
+
+        /**
+         * affine transform of points, the last row of the matrix is assumed to be (0, 0, 1).
+         * src and dst may be the same array.
+         */
+        inline void transform(const mat3f & m, const vec2f * src, vec2f * dst, size_type count) {
+#if defined(NITROGL_SIMD_AVX2) || defined(NITROGL_SIMD_SSE2)
+            const float * in = reinterpret_cast<const float *>(src);
+            float * out = reinterpret_cast<float *>(dst);
+            // for lanes {x0, y0, x1, y1}: {x0, x0, x1, x1}*col_x + {y0, y0, y1, y1}*col_y + col_t
+            const __m128 col_x = _mm_setr_ps(m(0,0), m(1,0), m(0,0), m(1,0));
+            const __m128 col_y = _mm_setr_ps(m(0,1), m(1,1), m(0,1), m(1,1));
+            const __m128 col_t = _mm_setr_ps(m(0,2), m(1,2), m(0,2), m(1,2));
+            size_type ix = 0;
+#if defined(NITROGL_SIMD_AVX2)
+            const __m256 col_x8 = _mm256_set_m128(col_x, col_x);
+            const __m256 col_y8 = _mm256_set_m128(col_y, col_y);
+            const __m256 col_t8 = _mm256_set_m128(col_t, col_t);
+            for (; ix + 4 <= count; ix+=4) {
+                const __m256 v = _mm256_loadu_ps(in + ix*2);
+                // no fma, so the results match the scalar kernel
+                const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_moveldup_ps(v), col_x8),
+                                                             _mm256_mul_ps(_mm256_movehdup_ps(v), col_y8)),
+                                               col_t8);
+                _mm256_storeu_ps(out + ix*2, r);
+            }
+#endif
+            for (; ix + 2 <= count; ix+=2) {
+                const __m128 v = _mm_loadu_ps(in + ix*2);
+                const __m128 xx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+                const __m128 yy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+                _mm_storeu_ps(out + ix*2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, col_x),
+                                                                _mm_mul_ps(yy, col_y)), col_t));
+            }
+            if(ix<count) scalar::transform(m, src + ix, dst + ix, count - ix);
+#elif defined(NITROGL_SIMD_NEON)
+            const float * in = reinterpret_cast<const float *>(src);
+            float * out = reinterpret_cast<float *>(dst);
+            const float32x4_t a = vdupq_n_f32(m(0,0)), b = vdupq_n_f32(m(0,1)), c = vdupq_n_f32(m(0,2));
+            const float32x4_t d = vdupq_n_f32(m(1,0)), e = vdupq_n_f32(m(1,1)), f = vdupq_n_f32(m(1,2));
+            size_type ix = 0;
+            for (; ix + 4 <= count; ix+=4) {
+                const float32x4x2_t v = vld2q_f32(in + ix*2);
+                float32x4x2_t r;
+                // no fused multiply-add, so the results match the scalar kernel
+                r.val[0] = vaddq_f32(vaddq_f32(vmulq_f32(a, v.val[0]), vmulq_f32(b, v.val[1])), c);
+                r.val[1] = vaddq_f32(vaddq_f32(vmulq_f32(d, v.val[0]), vmulq_f32(e, v.val[1])), f);
+                vst2q_f32(out + ix*2, r);
+            }
+            if(ix<count) scalar::transform(m, src + ix, dst + ix, count - ix);
+#else
+            scalar::transform(m, src, dst, count);
+#endif
+        }
+    }
+}
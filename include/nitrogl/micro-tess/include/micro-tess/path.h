@@ -25,6 +25,7 @@
 #include "elliptic_arc_divider.h"
 #include "stroke_tessellation.h"
 #include "planarize_division.h"
+#include "vertex_cache_reorder.h"
 #include "chunker.h"
 #include "std_rebind_allocator.h"
 #include "traits.h"
@@ -50,14 +51,19 @@ namespace microtess {
      * @tparam container_template_type a template of a linear container of the
      *          form Container<value_type, allocator_type> for internal usage
      * @tparam Allocator an allocator type for internal usage
+     * @tparam output_index the type of the output indices, 16 bit indices halve the indices
+     *          buffers. A tessellation with more vertices, than they address, is redone
+     *          with 32 bit indices into `output_wide_indices`
      */
     template<typename number,
              template<typename...> class container_template_type=dynamic_array,
-             class Allocator=std_rebind_allocator<>>
+             class Allocator=std_rebind_allocator<>,
+             typename output_index=unsigned int>
     class path {
     public:
         struct buffers;
         using index = unsigned int;
+        using output_index_type = output_index;
         using number_type = number;
         using vertex = microtess::vec2<number>;
         using allocator_type = Allocator;
@@ -297,17 +303,21 @@ namespace microtess {
 
         struct buffers {
             using allocator_type_vertices = typename allocator_type::template rebind<vertex>::other;
-            using allocator_type_indices = typename allocator_type::template rebind<index>::other;
+            using allocator_type_indices = typename allocator_type::template rebind<output_index>::other;
+            using allocator_type_wide_indices = typename allocator_type::template rebind<index>::other;
             using allocator_type_boundaries = typename allocator_type::template rebind<triangles::boundary_info>::other;
 
             using vertices = container_template_type<vertex, allocator_type_vertices>;
-            using indices = container_template_type<index, allocator_type_indices>;
+            using indices = container_template_type<output_index, allocator_type_indices>;
+            using wide_indices = container_template_type<index, allocator_type_wide_indices>;
             using boundaries = container_template_type<triangles::boundary_info,
                     allocator_type_boundaries>;
             using trapezes = vertices;
 
             vertices output_vertices;
             indices output_indices;
+            // the indices, when output_indices can not address all of the vertices
+            wide_indices output_wide_indices;
             boundaries output_boundary;
             trapezes DEBUG_output_trapezes;
             triangles::indices output_indices_type;
@@ -317,6 +327,7 @@ namespace microtess {
                     allocator(allocator),
                     output_vertices(allocator_type_vertices(allocator)),
                     output_indices(allocator_type_indices(allocator)),
+                    output_wide_indices(allocator_type_wide_indices(allocator)),
                     output_boundary(allocator_type_boundaries(allocator)),
                     DEBUG_output_trapezes(allocator_type_vertices(allocator)),
                     output_indices_type() {}
@@ -324,6 +335,7 @@ namespace microtess {
                     allocator(val.allocator),
                     output_vertices(microtess::traits::move(val.output_vertices)),
                     output_indices(microtess::traits::move(val.output_indices)),
+                    output_wide_indices(microtess::traits::move(val.output_wide_indices)),
                     output_boundary(microtess::traits::move(val.output_boundary)),
                     DEBUG_output_trapezes(microtess::traits::move(val.DEBUG_output_trapezes)),
                     output_indices_type(val.output_indices_type) {
@@ -336,6 +348,7 @@ namespace microtess {
             void move_from(buffers & val) {
                 output_vertices=microtess::traits::move(val.output_vertices);
                 output_indices=microtess::traits::move(val.output_indices);
+                output_wide_indices=microtess::traits::move(val.output_wide_indices);
                 output_boundary=microtess::traits::move(val.output_boundary);
                 DEBUG_output_trapezes=microtess::traits::move(val.DEBUG_output_trapezes);
                 output_indices_type=val.output_indices_type;
@@ -345,24 +358,42 @@ namespace microtess {
                 DEBUG_output_trapezes = trapezes(allocator);
                 output_vertices = vertices(allocator);
                 output_indices = indices(allocator);
+                output_wide_indices = wide_indices(allocator);
                 output_boundary = boundaries(allocator);
             }
             void clear() {
                 DEBUG_output_trapezes.clear();
                 output_vertices.clear();
                 output_indices.clear();
+                output_wide_indices.clear();
                 output_boundary.clear();
             }
+            /**
+             * if the indices are in `output_wide_indices` instead of `output_indices`
+             */
+            bool are_indices_wide() const { return output_wide_indices.size()!=0; }
+            /**
+             * if output_index addresses all of the output vertices
+             */
+            bool fits_output_index() const {
+                return sizeof(output_index)>=sizeof(index) ||
+                       output_vertices.size() <= unsigned(output_index(~output_index(0))) + 1u;
+            }
         };
 
     private:
         struct fill_cache_info {
-            fill_rule rule; tess_quality quality;
+            fill_rule rule; tess_quality quality; bool vertex_cache;
             bool operator==(const fill_cache_info &val) {
                 bool a= rule==val.rule &&
                         quality==val.quality;
                 return a;
             }
+            // reordered triangles are the same geometry, so they also satisfy a request
+            // without reordering
+            bool satisfied_by(const fill_cache_info &cached) {
+                return *this==cached && (cached.vertex_cache || !vertex_cache);
+            }
         };
 
         struct stroke_cache_info {
@@ -413,35 +444,99 @@ namespace microtess {
         stroke_cache_info _latest_stroke_cache_info;
         fill_cache_info _latest_fill_cache_info;
 
+        template <bool APPLY_MERGE, unsigned MAX_ITERATIONS, class indices_type>
+        void fill_into(indices_type & indices, const fill_rule &rule, const tess_quality &quality,
+                       bool compute_boundary_buffer, bool debug_trapezes,
+                       bool optimize_vertex_cache) {
+            using planarize_division_tess = planarize_division<number,
+                decltype(_tess_fill.output_vertices),
+                indices_type,
+                decltype(_tess_fill.output_boundary),
+                allocator_type,
+                APPLY_MERGE, MAX_ITERATIONS>;
+
+            planarize_division_tess::template compute<decltype(_paths_vertices)>(
+                    _paths_vertices, rule, quality,
+                    _tess_fill.output_vertices,
+                    _tess_fill.output_indices_type,
+                    indices,
+                    compute_boundary_buffer ? &_tess_fill.output_boundary : nullptr,
+                    debug_trapezes ? &_tess_fill.DEBUG_output_trapezes : nullptr,
+                    _allocator);
+
+            const auto type = _tess_fill.output_indices_type;
+            if(optimize_vertex_cache && (type==triangles::indices::TRIANGLES ||
+                                         type==triangles::indices::TRIANGLES_WITH_BOUNDARY)) {
+                using reorder = vertex_cache_reorder<indices_type,
+                        decltype(_tess_fill.output_boundary), allocator_type>;
+                reorder::compute(indices, _tess_fill.output_vertices.size(),
+                                 compute_boundary_buffer ? &_tess_fill.output_boundary : nullptr,
+                                 _allocator);
+            }
+        }
+
+        template<class Iterable, class indices_type>
+        void stroke_into(indices_type & indices, const number & stroke_width,
+                         const stroke_cap &cap, const stroke_line_join &line_join,
+                         const int miter_limit, const Iterable & stroke_dash_array,
+                         int stroke_dash_offset, bool compute_boundary_buffer) {
+            unsigned paths = _paths_vertices.size();
+            for (unsigned ix = 0; ix < paths; ++ix) {
+                auto chunk = _paths_vertices[ix];
+                const auto chunk_size = chunk.size();
+                if(chunk_size==0) continue;
+                bool isClosing = chunk_size >= 3 && chunk[chunk_size - 3] == chunk[chunk_size - 1]
+                                 && chunk[chunk_size - 3] == chunk[chunk_size - 2];
+                using stroke_tess = stroke_tessellation<number, decltype(_tess_stroke.output_vertices),
+                            indices_type, decltype(_tess_stroke.output_boundary)>;
+
+                stroke_tess::template compute_with_dashes<Iterable>(
+                        stroke_width,
+                        isClosing,
+                        cap, line_join,
+                        miter_limit,
+                        stroke_dash_array, stroke_dash_offset,
+                        chunk.data(), chunk_size - (isClosing?2:0),
+                        _tess_stroke.output_vertices,
+                        indices,
+                        _tess_stroke.output_indices_type,
+                        compute_boundary_buffer ? &_tess_stroke.output_boundary: nullptr);
+            }
+        }
+
     public:
+        /**
+         * tessellate the fill of the path, the result is cached until the path changes
+         * @param rule fill rule
+         * @param quality tessellation quality
+         * @param compute_boundary_buffer compute per triangle boundary info
+         * @param debug_trapezes output the trapezes for debugging
+         * @param optimize_vertex_cache reorder the triangles for post transform vertex cache
+         *        reuse, see vertex_cache_reorder. worth it for large meshes, that are drawn
+         *        many times. later requests without it, re-use the reordered buffers.
+         */
         template <bool APPLY_MERGE=true, unsigned MAX_ITERATIONS=200>
         buffers & tessellateFill(const fill_rule &rule=fill_rule::non_zero,
                                  const tess_quality &quality=tess_quality::better,
                                  bool compute_boundary_buffer = true,
-                                 bool debug_trapezes = false) {
-            fill_cache_info info{rule, quality};
-            const bool was_computed=(info==_latest_fill_cache_info) &&
+                                 bool debug_trapezes = false,
+                                 bool optimize_vertex_cache = false) {
+            fill_cache_info info{rule, quality, optimize_vertex_cache};
+            const bool was_computed=info.satisfied_by(_latest_fill_cache_info) &&
                     _tess_fill.output_vertices.size()!=0;
             if(_invalid || !was_computed) {
                 _latest_fill_cache_info=info;
                 _invalid=false;
                 _tess_fill.clear();
 
-                using planarize_division_tess = planarize_division<number,
-                    decltype(_tess_fill.output_vertices),
-                    decltype(_tess_fill.output_indices),
-                    decltype(_tess_fill.output_boundary),
-                    allocator_type,
-                    APPLY_MERGE, MAX_ITERATIONS>;
-
-                planarize_division_tess::template compute<decltype(_paths_vertices)>(
-                        _paths_vertices, rule, quality,
-                        _tess_fill.output_vertices,
-                        _tess_fill.output_indices_type,
-                        _tess_fill.output_indices,
-                        compute_boundary_buffer ? &_tess_fill.output_boundary : nullptr,
-                        debug_trapezes ? &_tess_fill.DEBUG_output_trapezes : nullptr,
-                        _allocator);
+                fill_into<APPLY_MERGE, MAX_ITERATIONS>(_tess_fill.output_indices, rule, quality, compute_boundary_buffer,
+                          debug_trapezes, optimize_vertex_cache);
+                // narrow indices wrap above their range, so tessellate again with wide indices
+                if(!_tess_fill.fits_output_index()) {
+                    _tess_fill.clear();
+                    fill_into<APPLY_MERGE, MAX_ITERATIONS>(_tess_fill.output_wide_indices, rule, quality, compute_boundary_buffer,
+                              debug_trapezes, optimize_vertex_cache);
+                }
             }
             return _tess_fill;
         }
@@ -464,27 +559,15 @@ namespace microtess {
                 _invalid=false;
                 _latest_stroke_cache_info=info;
                 _tess_stroke.clear();
-                unsigned paths = _paths_vertices.size();
-                for (unsigned ix = 0; ix < paths; ++ix) {
-                    auto chunk = _paths_vertices[ix];
-                    const auto chunk_size = chunk.size();
-                    if(chunk_size==0) continue;
-                    bool isClosing = chunk_size >= 3 && chunk[chunk_size - 3] == chunk[chunk_size - 1]
-                                     && chunk[chunk_size - 3] == chunk[chunk_size - 2];
-                    using stroke_tess = stroke_tessellation<number, decltype(_tess_stroke.output_vertices),
-                                decltype(_tess_stroke.output_indices), decltype(_tess_stroke.output_boundary)>;
-
-                    stroke_tess::template compute_with_dashes<Iterable>(
-                            stroke_width,
-                            isClosing,
-                            cap, line_join,
-                            miter_limit,
-                            stroke_dash_array, stroke_dash_offset,
-                            chunk.data(), chunk_size - (isClosing?2:0),
-                            _tess_stroke.output_vertices,
-                            _tess_stroke.output_indices,
-                            _tess_stroke.output_indices_type,
-                            compute_boundary_buffer ? &_tess_stroke.output_boundary: nullptr);
+                stroke_into<Iterable>(_tess_stroke.output_indices, stroke_width, cap, line_join,
+                                      miter_limit, stroke_dash_array, stroke_dash_offset,
+                                      compute_boundary_buffer);
+                // narrow indices wrap above their range, so tessellate again with wide indices
+                if(!_tess_stroke.fits_output_index()) {
+                    _tess_stroke.clear();
+                    stroke_into<Iterable>(_tess_stroke.output_wide_indices, stroke_width, cap, line_join,
+                                          miter_limit, stroke_dash_array, stroke_dash_offset,
+                                          compute_boundary_buffer);
                 }
             }
             return _tess_stroke;
@@ -0,0 +1,169 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "triangles.h"
+#include "dynamic_array.h"
+
+namespace microtess {
+    /**
+     * Post transform vertex cache reordering of indexed triangles, with the linear time
+     * Tipsify algorithm (Sander, Nehab, Barczak 2007). Tessellators emit triangles in
+     * construction order, this reorders them, so triangles that share vertices are emitted
+     * close to each other, which improves vertex reuse of GPUs (and software rasterizers).
+     * Vertices are not moved, only the order of the triangles changes.
+     *
+     * @tparam container_indices the indices container type
+     * @tparam container_boundary the boundary container type
+     * @tparam allocator_type allocator for the temporary buffers
+     */
+    template<class container_indices, class container_boundary, class allocator_type>
+    class vertex_cache_reorder {
+    public:
+        using index = unsigned int;
+
+        vertex_cache_reorder()=delete;
+        vertex_cache_reorder(const vertex_cache_reorder &)=delete;
+        vertex_cache_reorder(vertex_cache_reorder &&)=delete;
+        vertex_cache_reorder & operator=(const vertex_cache_reorder &)=delete;
+        vertex_cache_reorder & operator=(vertex_cache_reorder &&)=delete;
+        ~vertex_cache_reorder()=delete;
+
+        /**
+         * Reorder TRIANGLES (or TRIANGLES_WITH_BOUNDARY) indices in place
+         * @param indices the triangles indices
+         * @param vertices_count the count of vertices, the indices refer to
+         * @param boundary_buffer (optional) per triangle boundary info, reordered along
+         * @param allocator allocator for the temporary buffers
+         * @param cache_size the vertex cache size to optimize for
+         */
+        static
+        void compute(container_indices & indices,
+                     index vertices_count,
+                     container_boundary * boundary_buffer,
+                     const allocator_type & allocator=allocator_type(),
+                     index cache_size=16) {
+            using rebind_index = typename allocator_type::template rebind<index>::other;
+            using rebind_byte = typename allocator_type::template rebind<unsigned char>::other;
+            using rebind_boundary = typename allocator_type::template rebind<triangles::boundary_info>::other;
+            using index_array = dynamic_array<index, rebind_index>;
+            using byte_array = dynamic_array<unsigned char, rebind_byte>;
+            using boundary_array = dynamic_array<triangles::boundary_info, rebind_boundary>;
+
+            const index indices_count = indices.size();
+            const index triangles_count = indices_count/3;
+            if(triangles_count<2 || indices_count%3 || vertices_count==0) return;
+            const bool has_boundary = boundary_buffer && boundary_buffer->size()==triangles_count;
+
+            // vertex -> triangles adjacency, in compressed rows
+            index_array offsets(vertices_count+1, 0u, rebind_index(allocator));
+            for (index ix = 0; ix < indices_count; ++ix) {
+                const index v = index(indices[ix]);
+                if(v>=vertices_count) return;
+                ++offsets[v+1];
+            }
+            for (index ix = 0; ix < vertices_count; ++ix) offsets[ix+1] += offsets[ix];
+            index_array adjacency(indices_count, 0u, rebind_index(allocator));
+            // live triangles of each vertex, used as the fill cursor first
+            index_array live(vertices_count, 0u, rebind_index(allocator));
+            for (index ix = 0; ix < indices_count; ++ix) {
+                const index v = index(indices[ix]);
+                adjacency[offsets[v] + live[v]++] = ix/3;
+            }
+            // cache time stamps, initial stamps are outside of the cache
+            index_array stamps(vertices_count, 0u, rebind_index(allocator));
+            index_array dead_end{rebind_index(allocator)};
+            index_array candidates{rebind_index(allocator)};
+            index_array order{rebind_index(allocator)};
+            byte_array emitted(triangles_count, (unsigned char)0, rebind_byte(allocator));
+            dead_end.reserve(indices_count);
+            order.reserve(triangles_count);
+
+            index time = cache_size + 1;
+            index cursor = 0;
+            int fanning = 0;
+            while (fanning>=0) {
+                // emit all the live triangles of the fanning vertex
+                const auto f = index(fanning);
+                candidates.clear();
+                for (index ix = offsets[f]; ix < offsets[f+1]; ++ix) {
+                    const index t = adjacency[ix];
+                    if(emitted[t]) continue;
+                    emitted[t] = 1;
+                    order.push_back(t);
+                    for (index jx = 0; jx < 3; ++jx) {
+                        const index v = index(indices[t*3 + jx]);
+                        dead_end.push_back(v);
+                        candidates.push_back(v);
+                        --live[v];
+                        // a cache miss
+                        if(time - stamps[v] > cache_size) stamps[v] = time++;
+                    }
+                }
+                // next fanning vertex: a candidate that will still be in the cache after its
+                // triangles were emitted, the oldest one is preferred
+                fanning = -1;
+                int best = -1;
+                for (index ix = 0; ix < candidates.size(); ++ix) {
+                    const index v = candidates[ix];
+                    if(live[v]==0) continue;
+                    int priority = 0;
+                    if(time - stamps[v] + 2*live[v] <= cache_size) priority = int(time - stamps[v]);
+                    if(priority>best) { best = priority; fanning = int(v); }
+                }
+                if(fanning>=0) continue;
+                // dead end, recently referenced vertices first, then the next live vertex
+                while (dead_end.size() && fanning<0) {
+                    const index v = dead_end.back(); dead_end.pop_back();
+                    if(live[v]) fanning = int(v);
+                }
+                for (; cursor < vertices_count && fanning<0; ++cursor)
+                    if(live[cursor]) fanning = int(cursor);
+            }
+
+            // apply the order
+            index_array old_indices{rebind_index(allocator)};
+            old_indices.reserve(indices_count);
+            for (index ix = 0; ix < indices_count; ++ix) old_indices.push_back(index(indices[ix]));
+            using value_type = typename container_indices::value_type;
+            for (index ix = 0; ix < triangles_count; ++ix)
+                for (index jx = 0; jx < 3; ++jx)
+                    indices[ix*3 + jx] = value_type(old_indices[order[ix]*3 + jx]);
+            if(has_boundary) {
+                boundary_array old_boundary{rebind_boundary(allocator)};
+                old_boundary.reserve(triangles_count);
+                for (index ix = 0; ix < triangles_count; ++ix) old_boundary.push_back((*boundary_buffer)[ix]);
+                for (index ix = 0; ix < triangles_count; ++ix) (*boundary_buffer)[ix] = old_boundary[order[ix]];
+            }
+        }
+
+        /**
+         * average cache miss ratio (ACMR) of TRIANGLES indices with a FIFO cache,
+         * 3.0 is the worst, 0.5 is about the best for regular meshes
+         */
+        static float acmr(const container_indices & indices, index cache_size=16) {
+            index fifo[64]; index head = 0, filled = 0, misses = 0;
+            cache_size = cache_size>64 ? 64 : (cache_size ? cache_size : 1);
+            const index triangles_count = indices.size()/3;
+            if(triangles_count==0) return 0.0f;
+            for (index ix = 0; ix < triangles_count*3; ++ix) {
+                const index v = index(indices[ix]);
+                bool hit = false;
+                for (index jx = 0; jx < filled; ++jx) if(fifo[jx]==v) { hit = true; break; }
+                if(hit) continue;
+                ++misses;
+                fifo[head] = v; head = (head+1)%cache_size;
+                if(filled<cache_size) ++filled;
+            }
+            return float(misses)/float(triangles_count);
+        }
+    };
+}
@@ -0,0 +1,84 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "debug.h"
+
+namespace nitrogl {
+
+    /**
+     * Tracks textures, whose mip-maps are stale after uploads, so mip-maps are generated
+     * once before sampling instead of after every upload. Textures are copied by value,
+     * so the state is kept by texture id and not in the texture.
+     *
+     * Notes:
+     * - `current()` is a per-thread instance, same as `texture_units`. If you switch contexts
+     *   on a thread, keep a `dirty_mip_maps` per context and `make_current` it.
+     */
+    class dirty_mip_maps {
+    public:
+        static constexpr unsigned max_tracked = 64;
+
+    private:
+        GLuint _ids[max_tracked];
+        unsigned _count;
+
+        static dirty_mip_maps *& current_pointer() {
+            static thread_local dirty_mip_maps * registry = nullptr;
+            return registry;
+        }
+
+    public:
+        dirty_mip_maps() : _ids(), _count(0) {}
+
+        /**
+         * the registry of the current context (per thread by default)
+         */
+        static dirty_mip_maps & current() {
+            auto * registry = current_pointer();
+            if(registry) return *registry;
+            static thread_local dirty_mip_maps default_registry;
+            return default_registry;
+        }
+        /**
+         * use your own registry for the current context, nullptr restores the default
+         */
+        static void make_current(dirty_mip_maps * registry) { current_pointer()=registry; }
+
+        /**
+         * mark the mip-maps of a texture as stale
+         * @return false if too many textures are tracked, then generate the mip-maps right away
+         */
+        bool mark(GLuint id) {
+            if(contains(id)) return true;
+            if(_count==max_tracked) return false;
+            _ids[_count++] = id;
+            return true;
+        }
+        bool contains(GLuint id) const {
+            for (unsigned ix = 0; ix < _count; ++ix)
+                if(_ids[ix]==id) return true;
+            return false;
+        }
+        /**
+         * @return true if the mip-maps of the texture were stale
+         */
+        bool clear(GLuint id) {
+            for (unsigned ix = 0; ix < _count; ++ix) {
+                if(_ids[ix]!=id) continue;
+                _ids[ix] = _ids[--_count];
+                return true;
+            }
+            return false;
+        }
+    };
+
+}
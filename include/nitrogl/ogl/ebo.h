@@ -41,11 +41,41 @@ namespace nitrogl {
         ~ebo_t() { del(); unbind(); }
 
         bool wasGenerated() const { return _id; }
-        void uploadData(const GLuint * array, GLsizeiptr array_size_bytes, GLenum usage=GL_STATIC_DRAW) const {
+        void uploadData(const void * array, GLsizeiptr array_size_bytes, GLenum usage=GL_STATIC_DRAW) const {
             if(_id==0) return;
             bind();
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, array_size_bytes, array, usage); glCheckError();
         }
+
+        /**
+         * Upload 32 bit indices. If the largest index fits 16 bits, the indices are narrowed
+         * to GL_UNSIGNED_SHORT while uploading, which halves the upload and lets gl-es 2 draw
+         * them without the OES_element_index_uint extension.
+         * @return the type of the uploaded indices, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+         */
+        GLenum uploadNarrowedData(const GLuint * array, GLsizeiptr count, GLenum usage=GL_STATIC_DRAW) const {
+            GLuint max = 0;
+            for (GLsizeiptr ix = 0; ix < count; ++ix)
+                max = array[ix]>max ? array[ix] : max;
+            if(max>0xFFFFu) {
+                uploadData(array, count*GLsizeiptr(sizeof(GLuint)), usage);
+                return GL_UNSIGNED_INT;
+            }
+            if(_id==0) return GL_UNSIGNED_SHORT;
+            bind();
+            constexpr GLsizeiptr chunk_size = 2048;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, count*GLsizeiptr(sizeof(GLushort)),
+                         nullptr, usage); glCheckError();
+            GLushort chunk[chunk_size];
+            for (GLsizeiptr offset = 0; offset < count; offset+=chunk_size) {
+                const GLsizeiptr n = count-offset<chunk_size ? count-offset : chunk_size;
+                for (GLsizeiptr ix = 0; ix < n; ++ix)
+                    chunk[ix] = GLushort(array[offset+ix]);
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset*GLsizeiptr(sizeof(GLushort)),
+                                n*GLsizeiptr(sizeof(GLushort)), chunk); glCheckError();
+            }
+            return GL_UNSIGNED_SHORT;
+        }
         GLuint id() const { return _id; }
         void del() { if(_id && owner) { glDeleteBuffers(1, &_id); glCheckError(); _id=0; } }
         void bind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _id); glCheckError(); }
@@ -0,0 +1,84 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "../_internal/ogl_info.h"
+
+namespace nitrogl {
+
+#ifdef NITROGL_SUPPORTS_FENCE_SYNC
+    /**
+     * A fence sync object, that is signaled, when the GPU has completed the commands, that
+     * were issued before it was inserted. Fences are owned and move only.
+     */
+    class fence_t {
+        GLsync _sync;
+
+    public:
+        fence_t() : _sync(nullptr) {}
+        fence_t(fence_t && o) noexcept : _sync(o._sync) { o._sync=nullptr; }
+        fence_t(const fence_t & o)=delete;
+        fence_t & operator=(const fence_t & o)=delete;
+        fence_t & operator=(fence_t && o) noexcept {
+            if(&o!=this) { del(); _sync=o._sync; o._sync=nullptr; }
+            return *this;
+        }
+        ~fence_t() { del(); }
+
+        /**
+         * insert a fence after the commands so far, it replaces the previous fence
+         */
+        void insert() {
+            del();
+            _sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); glCheckError();
+        }
+
+        bool wasInserted() const { return _sync!=nullptr; }
+
+        /**
+         * non blocking query
+         * @return true if the fence was signaled, or was never inserted
+         */
+        bool isSignaled() const {
+            if(!_sync) return true;
+            GLint status = GL_UNSIGNALED;
+            glGetSynciv(_sync, GL_SYNC_STATUS, 1, nullptr, &status); glCheckError();
+            return status==GL_SIGNALED;
+        }
+
+        /**
+         * block until the fence is signaled, the fence is deleted afterwards
+         * @param timeout_ns nanoseconds to wait at most
+         * @return false if the timeout expired first, or the wait failed (lost context),
+         *         then the fence is kept
+         */
+        bool wait(GLuint64 timeout_ns=GLuint64(~0ull)) {
+            if(!_sync) return true;
+            // flush on the first wait only, so the fence is sure to be submitted
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            const GLuint64 step = 1000000000ull; // a second
+            for (;;) {
+                const GLuint64 timeout = timeout_ns<step ? timeout_ns : step;
+                const GLenum res = glClientWaitSync(_sync, flags, timeout); glCheckError();
+                if(res==GL_ALREADY_SIGNALED || res==GL_CONDITION_SATISFIED) break;
+                // a failed wait (lost context) never signals, so it does not block either
+                if(res==GL_WAIT_FAILED) return false;
+                if(timeout_ns<=step) return false;
+                timeout_ns -= step; flags = 0;
+            }
+            del();
+            return true;
+        }
+
+        void del() { if(_sync) { glDeleteSync(_sync); glCheckError(); _sync=nullptr; } }
+    };
+#endif
+}
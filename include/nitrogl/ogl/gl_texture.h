@@ -11,6 +11,8 @@
 #pragma once
 
 #include "debug.h"
+#include "texture_units.h"
+#include "dirty_mip_maps.h"
 
 namespace nitrogl {
 
@@ -20,6 +22,8 @@ namespace nitrogl {
         static GLenum bits2type(unsigned bits)
         { return (bits<=8) ? GL_UNSIGNED_BYTE : (bits<=16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT); }
         static unsigned max(unsigned a, unsigned b) { return a<b ? b : a; }
+        static bool requires_mip_maps(GLint filter_min)
+        { return filter_min!=GL_NEAREST && filter_min!=GL_LINEAR; }
 
     public:
         static GLint next_texture_unit() {
@@ -124,9 +128,13 @@ namespace nitrogl {
         bool owner, _is_pre_mul_alpha;
         GLint _slot;
 
+        // uploads and parameters bind to the scratch unit, unless the slot is fixed
+        GLint edit_unit() const { return _slot<0 ? 0 : _slot; }
+
 //        gl_texture(GLuint id, GLint internalformat, GLsizei width, GLsizei height, bool owner) :
 //            _id(id), _internalformat(internalformat), _width(width), _height(height), owner(owner) {};
-        gl_texture() : _id(-1) {  } // ungenerated for internal usage
+        gl_texture() : _id(0), _internalformat(0), _width(0), _height(0),
+                       owner(false), _is_pre_mul_alpha(false), _slot(-1) {} // ungenerated for internal usage
     public:
         /**
          * The most general ctor
@@ -135,10 +143,10 @@ namespace nitrogl {
          * @param height The height of the image data
          * @param internalformat The Internal Format of pixel data in the GPU
          * @param is_pre_mul_alpha Is this texture pre-multiplied alpha ?
-         * @param slot The slot index of the texture
+         * @param slot A fixed texture unit, -1 binds the texture to a unit of each draw, see `use()`
          */
         gl_texture(GLsizei width, GLsizei height, GLint internalformat=GL_RGBA, bool is_pre_mul_alpha=false,
-                   GLint slot=next_texture_unit_minus_zero()) :
+                   GLint slot=-1) :
             _id(0), _internalformat(internalformat), _width(width), _height(height), owner(true),
             _is_pre_mul_alpha(is_pre_mul_alpha), _slot(slot) {
             generate();
@@ -196,7 +204,7 @@ namespace nitrogl {
                          GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR_MIPMAP_LINEAR,
                          GLint wrap_s=GL_REPEAT, GLint wrap_t=GL_REPEAT) const {
             if(!wasGenerated()) return false;
-            use(_slot);
+            use(edit_unit());
             glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_row_alignment); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
@@ -204,8 +212,7 @@ namespace nitrogl {
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
             glTexImage2D(GL_TEXTURE_2D, 0, _internalformat, _width, _height, 0,
                          format, type, data); glCheckError();
-            const bool requires_mip_maps = filter_min!=GL_NEAREST && filter_min!=GL_LINEAR;
-            if(requires_mip_maps) { glGenerateMipmap(GL_TEXTURE_2D); glCheckError(); }
+            if(requires_mip_maps(filter_min)) markMipMapsDirty();
             return true;
         }
 
@@ -221,38 +228,74 @@ namespace nitrogl {
                             GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR_MIPMAP_LINEAR,
                             GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE) const {
             if(!wasGenerated()) return false;
-            use(_slot);
+            use(edit_unit());
             glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_row_alignment); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
             glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, pixels); glCheckError();
-            const bool requires_mip_maps = filter_min!=GL_NEAREST && filter_min!=GL_LINEAR;
-            if(requires_mip_maps) { glGenerateMipmap(GL_TEXTURE_2D); glCheckError(); }
+            if(requires_mip_maps(filter_min)) markMipMapsDirty();
             return true;
         }
+        /**
+         * Uploads do not generate mip-maps right away, they only mark them as stale, so
+         * many sub-image uploads cost a single mip-maps generation, which happens right
+         * before sampling (see `createMipMapsIfDirty`). If you render into this texture
+         * (fbo), call `markMipMapsDirty()` afterwards.
+         */
         void createMipMaps() const {
-            use(_slot);
+            use(edit_unit());
+            glGenerateMipmap(GL_TEXTURE_2D); glCheckError();
+            dirty_mip_maps::current().clear(_id);
+        }
+        void markMipMapsDirty() const {
+            if(!dirty_mip_maps::current().mark(_id)) createMipMaps();
+        }
+        bool areMipMapsDirty() const { return dirty_mip_maps::current().contains(_id); }
+        /**
+         * generate mip-maps only if they are stale
+         * @return true if mip-maps were generated
+         */
+        bool createMipMapsIfDirty() const {
+            if(!dirty_mip_maps::current().clear(_id)) return false;
+            use(edit_unit());
             glGenerateMipmap(GL_TEXTURE_2D); glCheckError();
+            return true;
+        }
+        /**
+         * @return the amount of mip-map levels of the full mip-maps chain
+         */
+        GLint levels() const {
+            GLint levels=1;
+            for (GLsizei s = _width<_height ? _height : _width; s>1; s>>=1) ++levels;
+            return levels;
         }
         void update_parameters(GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR_MIPMAP_LINEAR,
                                GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE) const {
-            use(_slot);
+            use(edit_unit());
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s); glCheckError();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
-            const bool requires_mip_maps = filter_min!=GL_NEAREST && filter_min!=GL_LINEAR;
-            if(requires_mip_maps) { glGenerateMipmap(GL_TEXTURE_2D); glCheckError(); }
+            if(requires_mip_maps(filter_min)) markMipMapsDirty();
         }
         bool is_premul_alpha() const { return _is_pre_mul_alpha; }
         GLuint id() const { return _id; }
-        static void unuse() { glBindTexture(GL_TEXTURE_2D, 0); glCheckError(); }
-        void use() const { use(_slot); }
+        static void unuse() { texture_units::current().unbind(GL_TEXTURE_2D); }
+        /**
+         * bind the texture for a draw. A texture without a fixed slot is bound to a unit,
+         * that no other texture of the current draw uses, see `texture_units`
+         * @return the unit, upload it to the sampler uniform
+         */
+        GLint use() const {
+            const GLint unit = _slot<0 ? texture_units::current().unit_for(GL_TEXTURE_2D, _id) : _slot;
+            use(unit);
+            return unit;
+        }
         void use(int index) const {
-            glActiveTexture(GL_TEXTURE0 + (unsigned int)index); glCheckError();
-            glBindTexture(GL_TEXTURE_2D, _id); glCheckError();
+            // redundant activations and bindings are skipped
+            texture_units::current().bind(GL_TEXTURE_2D, _id, index);
         }
         GLsizei width() const { return _width; }
         GLsizei height() const { return _height; }
@@ -260,7 +303,11 @@ namespace nitrogl {
         GLint internalFormat() const { return _internalformat; }
 
         void del() {
-            if(_id && owner) { glDeleteTextures(1, &_id); glCheckError(); }
+            if(_id && owner) {
+                texture_units::current().forget(_id);
+                dirty_mip_maps::current().clear(_id);
+                glDeleteTextures(1, &_id); glCheckError();
+            }
             _id=_internalformat=_width=_height=0;
         }
     };
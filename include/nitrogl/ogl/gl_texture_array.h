@@ -0,0 +1,176 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "gl_texture.h"
+
+namespace nitrogl {
+
+    /**
+     * A GL_TEXTURE_2D_ARRAY texture, that holds `layers` images of the same size.
+     * Requires gl >= 3.0 or gl-es >= 3.0.
+     * - Sampling different layers does not change the texture unit, therefore many images
+     *   can be sampled with the same shader program, see `texture_array_sampler`.
+     * - copies are non-owning, moves transfer ownership (same as gl_texture)
+     */
+    class gl_texture_array {
+    public:
+        static gl_texture_array un_generated_dummy() { return gl_texture_array(); }
+        /**
+         * create an empty texture array with storage for all the layers
+         */
+        static gl_texture_array empty(GLsizei width, GLsizei height, GLsizei layers,
+                                      GLint internalformat=GL_RGBA, bool is_premul_alpha=false,
+                                      GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR,
+                                      GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE) {
+            auto tex = gl_texture_array(width, height, layers, internalformat, is_premul_alpha);
+            tex.allocateStorage(filter_mag, filter_min, wrap_s, wrap_t);
+            return tex;
+        }
+
+    private:
+        GLuint _id;
+        GLint _internalformat;
+        GLsizei _width, _height, _layers;
+        bool owner, _is_pre_mul_alpha;
+        GLint _slot;
+
+        // uploads and parameters bind to the scratch unit, unless the slot is fixed
+        GLint edit_unit() const { return _slot<0 ? 0 : _slot; }
+
+        gl_texture_array() : _id(0), _internalformat(0), _width(0), _height(0), _layers(0),
+                             owner(false), _is_pre_mul_alpha(false), _slot(-1) {} // ungenerated for internal usage
+    public:
+        /**
+         * @param width The width of each layer
+         * @param height The height of each layer
+         * @param layers The amount of layers
+         * @param internalformat The Internal Format of pixel data in the GPU
+         * @param is_pre_mul_alpha Is this texture pre-multiplied alpha ?
+         * @param slot A fixed texture unit, -1 binds the texture to a unit of each draw, see `use()`
+         */
+        gl_texture_array(GLsizei width, GLsizei height, GLsizei layers,
+                         GLint internalformat=GL_RGBA, bool is_pre_mul_alpha=false,
+                         GLint slot=-1) :
+                _id(0), _internalformat(internalformat), _width(width), _height(height),
+                _layers(layers), owner(true), _is_pre_mul_alpha(is_pre_mul_alpha), _slot(slot) {
+            generate();
+        }
+        gl_texture_array(gl_texture_array && o) noexcept : _id(o._id), _internalformat(o._internalformat),
+                _width(o._width), _height(o._height), _layers(o._layers), owner(o.owner),
+                _is_pre_mul_alpha(o._is_pre_mul_alpha), _slot(o._slot) {
+            o._id=0; o.owner=false;
+        }
+        gl_texture_array & operator=(gl_texture_array && o) noexcept {
+            if(this!=&o) {
+                del();
+                _id=o._id; _internalformat=o._internalformat; _is_pre_mul_alpha=o._is_pre_mul_alpha;
+                _width=o._width, _height=o._height; _layers=o._layers; owner=o.owner; _slot=o._slot;
+                o._id=0; o.owner=false;
+            }
+            return *this;
+        }
+        gl_texture_array(const gl_texture_array & o) : _id(o._id), _internalformat(o._internalformat),
+                _width(o._width), _height(o._height), _layers(o._layers), owner(false),
+                _is_pre_mul_alpha(o._is_pre_mul_alpha), _slot(o._slot) {}
+        gl_texture_array & operator=(const gl_texture_array & o) {
+            if(this!=&o) {
+                del();
+                _id = o._id; _internalformat = o._internalformat;
+                _width = o._width, _height = o._height; _layers=o._layers;
+                _is_pre_mul_alpha=o._is_pre_mul_alpha; _slot=o._slot;
+                owner = false;
+            }
+            return *this;
+        }
+        ~gl_texture_array() { _id=_internalformat=_width=_height=_layers=0; }
+
+        void generate() {
+            if(!_id) {
+                glGenTextures(1, &_id); glCheckError();
+            }
+        }
+        bool wasGenerated() const { return _id; }
+
+        /**
+         * allocate undefined storage for all the layers
+         */
+        bool allocateStorage(GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR,
+                             GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE) const {
+            if(!wasGenerated()) return false;
+            use(edit_unit());
+            update_parameters(filter_mag, filter_min, wrap_s, wrap_t);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, _internalformat, _width, _height, _layers, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr); glCheckError();
+            return true;
+        }
+
+        /**
+         * upload a full image into a layer
+         * @param layer the layer index
+         * @param format layout of color channels in a pixel, GL_RGB/GL_RGBA/GL_RED etc..
+         * @param type The pixel type of each pixel in the image array
+         * @param data The image array of pixels, it's dimensions are (width x height)
+         * @param unpack_row_alignment row alignment of the image data (1|2|4|8)
+         */
+        bool uploadLayer(GLint layer, GLenum format, GLenum type, const void * data,
+                         GLint unpack_row_alignment=1) const {
+            if(!wasGenerated() || layer<0 || layer>=_layers) return false;
+            use(edit_unit());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_row_alignment); glCheckError();
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, _width, _height, 1,
+                            format, type, data); glCheckError();
+            return true;
+        }
+        void createMipMaps() const {
+            use(edit_unit());
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY); glCheckError();
+        }
+        void update_parameters(GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR,
+                               GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE) const {
+            use(edit_unit());
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap_s); glCheckError();
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
+        }
+        bool is_premul_alpha() const { return _is_pre_mul_alpha; }
+        GLuint id() const { return _id; }
+        static void unuse() { texture_units::current().unbind(GL_TEXTURE_2D_ARRAY); }
+        /**
+         * bind the texture for a draw. A texture without a fixed slot is bound to a unit,
+         * that no other texture of the current draw uses, see `texture_units`
+         * @return the unit, upload it to the sampler uniform
+         */
+        GLint use() const {
+            const GLint unit = _slot<0 ? texture_units::current().unit_for(GL_TEXTURE_2D_ARRAY, _id) : _slot;
+            use(unit);
+            return unit;
+        }
+        void use(int index) const {
+            // redundant activations and bindings are skipped
+            texture_units::current().bind(GL_TEXTURE_2D_ARRAY, _id, index);
+        }
+        GLsizei width() const { return _width; }
+        GLsizei height() const { return _height; }
+        GLsizei layers() const { return _layers; }
+        GLint slot() const { return _slot; }
+        GLint internalFormat() const { return _internalformat; }
+
+        void del() {
+            if(_id && owner) {
+                texture_units::current().forget(_id);
+                glDeleteTextures(1, &_id); glCheckError();
+            }
+            _id=_internalformat=_width=_height=_layers=0;
+        }
+    };
+}
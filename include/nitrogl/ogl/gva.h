@@ -26,6 +26,9 @@ namespace nitrogl {
         // stride can be calculated automatically if the buffer is interleaved or non.
         GLsizei stride;
         GLuint vbo; // corresponding vbo
+        // fixed point types are mapped to [0..1] (unsigned) or [-1..1] (signed) when
+        // GL_TRUE, otherwise they are converted to floats as is. defaults to GL_FALSE
+        GLboolean normalized;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "gl_texture.h"
+#include "../traits.h"
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
+
+namespace nitrogl {
+
+    /**
+     * A pool of offscreen render target textures (RGBA, linear filtering, clamped).
+     * - `acquire` returns an idle texture of the exact same dimensions if there is one,
+     *   otherwise a new texture is created with `gl_texture::empty`.
+     * - `release` returns a texture to the pool. At most `max_idle` idle textures are kept,
+     *   beyond that the least recently used idle textures are deleted.
+     * - acquired textures are non-owning copies, the pool owns all the textures.
+     * @tparam Allocator allocator for the internal book-keeping
+     */
+    template<class Allocator=nitrogl::std_rebind_allocator<>>
+    class render_target_pool {
+        struct entry_t {
+            gl_texture texture;
+            unsigned long stamp;
+            bool in_use;
+        };
+        using entries_allocator_t = typename Allocator::template rebind<entry_t>::other;
+
+        dynamic_array<entry_t, entries_allocator_t> _entries;
+        unsigned long _clock;
+        unsigned _max_idle;
+
+        int index_of(GLuint id) const {
+            for (unsigned ix = 0; ix < _entries.size(); ++ix)
+                if(_entries[ix].texture.id()==id) return int(ix);
+            return -1;
+        }
+
+        void remove_at(unsigned index) {
+            _entries[index].texture.del();
+            const unsigned last = _entries.size()-1;
+            if(index!=last) _entries[index] = nitrogl::traits::move(_entries[last]);
+            _entries.pop_back();
+        }
+
+    public:
+        /**
+         * @param max_idle how many idle textures to keep around
+         */
+        explicit render_target_pool(unsigned max_idle=4, const Allocator & allocator=Allocator()) :
+                _entries(entries_allocator_t(allocator)), _clock(0), _max_idle(max_idle) {}
+        render_target_pool(const render_target_pool &)=delete;
+        render_target_pool & operator=(const render_target_pool &)=delete;
+        ~render_target_pool() { clear(); }
+
+        /**
+         * @param width/height dimensions of the render target
+         * @param is_premul_alpha pre-multiplied alpha targets are recommended for offscreen work
+         * @return a non-owning copy of a texture, that is reserved until `release`
+         */
+        gl_texture acquire(GLsizei width, GLsizei height, bool is_premul_alpha=true) {
+            for (unsigned ix = 0; ix < _entries.size(); ++ix) {
+                auto & e = _entries[ix];
+                if(e.in_use || e.texture.width()!=width || e.texture.height()!=height ||
+                   e.texture.is_premul_alpha()!=is_premul_alpha) continue;
+                e.in_use = true; e.stamp = ++_clock;
+                return e.texture;
+            }
+            _entries.push_back({ gl_texture::empty(width, height, GL_RGBA, is_premul_alpha, 1,
+                                                   GL_LINEAR, GL_LINEAR,
+                                                   GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE),
+                                 ++_clock, true });
+            return _entries[_entries.size()-1].texture;
+        }
+
+        /**
+         * return a texture to the pool
+         */
+        void release(const gl_texture & texture) {
+            const int index = index_of(texture.id());
+            if(index<0) return;
+            _entries[index].in_use = false;
+            _entries[index].stamp = ++_clock;
+            trim(_max_idle);
+        }
+
+        /**
+         * delete the least recently used idle textures, until at most `max_idle` are left
+         */
+        void trim(unsigned max_idle=0) {
+            for (;;) {
+                unsigned idle = 0; int lru = -1;
+                for (unsigned ix = 0; ix < _entries.size(); ++ix) {
+                    const auto & e = _entries[ix];
+                    if(e.in_use) continue;
+                    ++idle;
+                    if(lru<0 || e.stamp<_entries[lru].stamp) lru = int(ix);
+                }
+                if(idle<=max_idle) return;
+                remove_at(unsigned(lru));
+            }
+        }
+
+        /**
+         * delete all the textures, including the acquired ones
+         */
+        void clear() {
+            for (unsigned ix = 0; ix < _entries.size(); ++ix)
+                _entries[ix].texture.del();
+            _entries.clear();
+        }
+
+        unsigned size() const { return _entries.size(); }
+        unsigned max_idle() const { return _max_idle; }
+    };
+
+}
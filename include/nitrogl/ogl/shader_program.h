@@ -350,7 +350,7 @@ namespace nitrogl {
                     case shader_attribute_component_type::Float:
 
                         glVertexAttribPointer((GLuint)it->index, GLint(it->size), it->type,
-                                              GL_FALSE, it->stride, it->offset); glCheckError();
+                                              it->normalized, it->stride, it->offset); glCheckError();
                         break;
 #ifdef SUPPORTS_INT_ATTRIBUTES
                     case shader_attribute_component_type::Integer:
@@ -0,0 +1,108 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "gl_texture_array.h"
+#include "../traits.h"
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Packs same-sized images into the layers of a single texture array.
+     * - All the allocated images share one texture and one texture unit, so every
+     *   `texture_array_sampler` of this allocator maps to the same shader program.
+     * - Freed layers are recycled by later allocations.
+     * @tparam Allocator allocator for the internal free list
+     */
+    template<class Allocator=nitrogl::std_rebind_allocator<>>
+    class texture_array_allocator {
+    public:
+        static constexpr GLint invalid_layer = -1;
+
+    private:
+        using layers_allocator_t = typename Allocator::template rebind<GLint>::other;
+        gl_texture_array _texture;
+        dynamic_array<GLint, layers_allocator_t> _free_layers;
+
+    public:
+        /**
+         * @param width width of each image
+         * @param height height of each image
+         * @param layers maximal amount of images
+         * @param internalformat The Internal Format of pixel data in the GPU
+         * @param is_premul_alpha are the images pre-multiplied alpha ?
+         */
+        texture_array_allocator(GLsizei width, GLsizei height, GLsizei layers,
+                                GLint internalformat=GL_RGBA, bool is_premul_alpha=false,
+                                GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR,
+                                const Allocator & allocator=Allocator()) :
+                _texture(gl_texture_array::empty(width, height, layers, internalformat, is_premul_alpha,
+                                                 filter_mag, filter_min)),
+                _free_layers(layers_allocator_t(allocator)) {
+            _free_layers.reserve(layers);
+            // stack of free layers, so the first allocations get the lower layers
+            for (GLint ix = layers-1; ix >= 0; --ix)
+                _free_layers.push_back(ix);
+        }
+        texture_array_allocator(const texture_array_allocator &)=delete;
+        texture_array_allocator & operator=(const texture_array_allocator &)=delete;
+        ~texture_array_allocator() { _texture.del(); }
+
+        /**
+         * reserve a layer without uploading data
+         * @return the layer index or `invalid_layer` if the array is full
+         */
+        GLint allocate() {
+            if(_free_layers.size()==0) return invalid_layer;
+            const GLint layer = _free_layers[_free_layers.size()-1];
+            _free_layers.pop_back();
+            return layer;
+        }
+
+        /**
+         * reserve a layer and upload an image of size (width x height) into it
+         * @return the layer index or `invalid_layer` if the array is full
+         */
+        GLint allocate(GLenum format, GLenum type, const void * data, GLint unpack_row_alignment=1) {
+            const GLint layer = allocate();
+            if(layer!=invalid_layer)
+                _texture.uploadLayer(layer, format, type, data, unpack_row_alignment);
+            return layer;
+        }
+
+        /**
+         * return a layer to the allocator, it's content is kept until it is reused.
+         * layers out of range, or that are already free, are ignored
+         */
+        void free(GLint layer) {
+            if(layer<0 || layer>=_texture.layers()) return;
+            for (unsigned ix = 0; ix < _free_layers.size(); ++ix)
+                if(_free_layers[ix]==layer) return;
+            _free_layers.push_back(layer);
+        }
+
+        GLsizei capacity() const { return _texture.layers(); }
+        GLsizei available() const { return GLsizei(_free_layers.size()); }
+        GLsizei used() const { return capacity() - available(); }
+        GLsizei width() const { return _texture.width(); }
+        GLsizei height() const { return _texture.height(); }
+        /**
+         * @return a non-owning copy of the texture array
+         */
+        const gl_texture_array & texture() const { return _texture; }
+    };
+
+}
@@ -0,0 +1,302 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "gl_texture.h"
+#include "fbo.h"
+#include "../traits.h"
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
+
+namespace nitrogl {
+
+    /**
+     * A dynamic texture atlas, that packs small images into shelves of a single large texture.
+     * - Images are uploaded with `gl_texture::uploadSubImage`, and each image gets a region
+     *   with pixel coordinates and normalized u0/v0/u1/v1 coordinates.
+     * - All the images share one texture, one texture unit and therefore one shader program,
+     *   see `texture_region_sampler`.
+     * - Removed images leave holes, that are reclaimed by `repack()`. Repacking is done on
+     *   the GPU and keeps the texture id, but moves regions, so regions should be re-queried
+     *   with `region(id)` when `generation()` changes.
+     * - When the atlas is full, `add` first repacks if images were removed, then (optionally)
+     *   evicts a batch of the least recently used images and repacks once. Use `touch(id)`
+     *   to mark an image as used.
+     * @tparam Allocator allocator for the internal book-keeping
+     */
+    template<class Allocator=nitrogl::std_rebind_allocator<>>
+    class texture_atlas {
+    public:
+        struct region_t {
+            unsigned id;
+            GLint x, y, width, height;
+            float u0, v0, u1, v1;
+            bool valid() const { return width>0; }
+        };
+
+    private:
+        struct shelf_t { GLint y, height, x_next; };
+        struct entry_t { region_t region; unsigned long stamp; bool alive; };
+        using shelves_allocator_t = typename Allocator::template rebind<shelf_t>::other;
+        using entries_allocator_t = typename Allocator::template rebind<entry_t>::other;
+        using indices_allocator_t = typename Allocator::template rebind<unsigned>::other;
+
+        gl_texture _texture;
+        GLint _padding;
+        GLint _next_shelf_y;
+        unsigned long _clock;
+        unsigned _generation;
+        unsigned _alive;
+        bool _holes; // images were removed since the last repack
+        dynamic_array<shelf_t, shelves_allocator_t> _shelves;
+        dynamic_array<entry_t, entries_allocator_t> _entries;
+
+        static region_t invalid_region() { return { 0, 0, 0, 0, 0, 0.0f, 0.0f, 0.0f, 0.0f }; }
+
+        void update_uvs(region_t & r) const {
+            const float w = float(_texture.width()), h = float(_texture.height());
+            r.u0 = float(r.x)/w; r.v0 = float(r.y)/h;
+            r.u1 = float(r.x + r.width)/w; r.v1 = float(r.y + r.height)/h;
+        }
+
+        /**
+         * find space for a (w x h) image in the shelves, best fit by shelf height
+         */
+        bool find_space(GLint w, GLint h, GLint & x, GLint & y) {
+            const GLint pw = w + _padding, ph = h + _padding;
+            const GLint W = _texture.width(), H = _texture.height();
+            if(pw>W || ph>H) return false;
+            int best = -1;
+            for (unsigned ix = 0; ix < _shelves.size(); ++ix) {
+                const auto & s = _shelves[ix];
+                if(s.height>=ph && W-s.x_next>=pw && (best<0 || s.height<_shelves[best].height))
+                    best = int(ix);
+            }
+            if(best<0) {
+                if(_next_shelf_y + ph > H) return false;
+                _shelves.push_back({ _next_shelf_y, ph, 0 });
+                _next_shelf_y += ph;
+                best = int(_shelves.size()-1);
+            }
+            auto & s = _shelves[best];
+            x = s.x_next; y = s.y;
+            s.x_next += pw;
+            return true;
+        }
+
+        /**
+         * @param freed accumulates the padded area of the evicted image
+         */
+        bool evict_least_recently_used(long & freed) {
+            int lru = -1;
+            for (unsigned ix = 0; ix < _entries.size(); ++ix) {
+                const auto & e = _entries[ix];
+                if(e.alive && (lru<0 || e.stamp<_entries[lru].stamp)) lru = int(ix);
+            }
+            if(lru<0) return false;
+            const auto & r = _entries[lru].region;
+            freed += long(r.width + _padding) * long(r.height + _padding);
+            remove(r.id);
+            return true;
+        }
+
+        static unsigned index_of(unsigned id) { return id & 0xFFFFu; }
+
+        unsigned acquire_entry() {
+            // reuse a dead entry, so the book-keeping stays compact. The upper bits of
+            // an id count the reuses of an entry, so stale ids are never confused.
+            for (unsigned ix = 0; ix < _entries.size(); ++ix)
+                if(!_entries[ix].alive) return ix;
+            _entries.push_back({ invalid_region(), 0, false });
+            return unsigned(_entries.size()-1);
+        }
+
+    public:
+        /**
+         * @param width width of the atlas texture
+         * @param height height of the atlas texture
+         * @param padding empty pixels between images to avoid bleeding with linear filtering
+         * @param is_premul_alpha are the images pre-multiplied alpha ?
+         */
+        texture_atlas(GLsizei width, GLsizei height, GLint padding=1, bool is_premul_alpha=false,
+                      const Allocator & allocator=Allocator()) :
+                _texture(gl_texture::empty(width, height, GL_RGBA, is_premul_alpha, 1,
+                                           GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE)),
+                _padding(padding), _next_shelf_y(0), _clock(0), _generation(0), _alive(0),
+                _holes(false), _shelves(shelves_allocator_t(allocator)), _entries(entries_allocator_t(allocator)) {
+        }
+        texture_atlas(const texture_atlas &)=delete;
+        texture_atlas & operator=(const texture_atlas &)=delete;
+        ~texture_atlas() { _texture.del(); }
+
+        /**
+         * reserve a region in the atlas without uploading pixels, for example to render
+         * into it. The content of the region is undefined.
+         * @param width/height dimensions of the region
+         * @param evict if the atlas is full even after repacking, evict least recently used images
+         * @return the region, check `valid()` for failure
+         */
+        region_t reserve(GLsizei width, GLsizei height, bool evict=true) {
+            // never fits, do not evict for it
+            if(width + _padding > _texture.width() || height + _padding > _texture.height())
+                return invalid_region();
+            GLint x, y;
+            bool found = find_space(width, height, x, y);
+            if(!found && _holes) {
+                // holes of removed images can be reclaimed
+                repack();
+                found = find_space(width, height, x, y);
+            }
+            // evict a batch of images, that frees at least the area of the region, then
+            // repack once. Shelves waste space, so every failed round doubles the batch
+            long target = long(width + _padding) * long(height + _padding);
+            while(!found && evict) {
+                long freed = 0;
+                while(freed<target && evict_least_recently_used(freed)) {}
+                if(!_holes) break;
+                repack();
+                found = find_space(width, height, x, y);
+                target *= 2;
+            }
+            if(!found) return invalid_region();
+
+            const unsigned index = acquire_entry();
+            auto & e = _entries[index];
+            const unsigned id = ((((e.region.id>>16) + 1) & 0xFFFFu)<<16) | index;
+            e.region = { id, x, y, GLint(width), GLint(height), 0.0f, 0.0f, 0.0f, 0.0f };
+            update_uvs(e.region);
+            e.stamp = ++_clock;
+            e.alive = true;
+            ++_alive;
+            return e.region;
+        }
+
+        /**
+         * add an image to the atlas
+         * @param width/height dimensions of the image
+         * @param format/type pixel layout of the image data, usually GL_RGBA/GL_UNSIGNED_BYTE
+         * @param data the pixels
+         * @param evict if the atlas is full even after repacking, evict least recently used images
+         * @return the region of the image, check `valid()` for failure
+         */
+        region_t add(GLsizei width, GLsizei height, GLenum format, GLenum type,
+                     const void * data, GLint unpack_row_alignment=1, bool evict=true) {
+            const auto region = reserve(width, height, evict);
+            if(!region.valid()) return region;
+            _texture.uploadSubImage(region.x, region.y, width, height, format, type, data,
+                                    unpack_row_alignment, GL_LINEAR, GL_LINEAR,
+                                    GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+            return region;
+        }
+
+        /**
+         * remove an image, it's space is reclaimed at the next `repack()`
+         */
+        void remove(unsigned id) {
+            if(!contains(id)) return;
+            _entries[index_of(id)].alive = false;
+            --_alive;
+            _holes = true;
+        }
+
+        bool contains(unsigned id) const {
+            const auto index = index_of(id);
+            return index<_entries.size() && _entries[index].alive && _entries[index].region.id==id;
+        }
+
+        /**
+         * @return the current region of an image, and marks it as recently used
+         */
+        region_t region(unsigned id) {
+            if(!contains(id)) return invalid_region();
+            touch(id);
+            return _entries[index_of(id)].region;
+        }
+
+        void touch(unsigned id) {
+            if(contains(id)) _entries[index_of(id)].stamp = ++_clock;
+        }
+
+        /**
+         * Repack all the alive images, tallest first, into fresh shelves.
+         * Pixels are moved on the GPU through a scratch texture, so the atlas texture (and
+         * samplers, that copied it) stays valid. Images, that do not fit anymore are removed.
+         */
+        void repack() {
+            using indices_t = dynamic_array<unsigned, indices_allocator_t>;
+            indices_t order{indices_allocator_t(_entries.get_allocator())};
+            for (unsigned ix = 0; ix < _entries.size(); ++ix)
+                if(_entries[ix].alive) order.push_back(ix);
+            // insertion sort by height, tallest first
+            for (unsigned ix = 1; ix < order.size(); ++ix) {
+                const unsigned v = order[ix];
+                int jx = int(ix) - 1;
+                for (; jx>=0 && _entries[order[jx]].region.height < _entries[v].region.height; --jx)
+                    order[jx+1] = order[jx];
+                order[jx+1] = v;
+            }
+
+            const GLsizei W = _texture.width(), H = _texture.height();
+            // snapshot the atlas into a scratch texture
+            auto scratch = gl_texture::empty(W, H, _texture.internalFormat(), _texture.is_premul_alpha(), 1,
+                                             GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+            {
+                fbo_t fbo;
+                fbo.attachTexture(_texture);
+                scratch.use(0);
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, W, H); glCheckError();
+                // copy back each alive image into it's new place
+                fbo.attachTexture(scratch);
+                _texture.use(0);
+                _shelves.clear(); _next_shelf_y = 0;
+                for (unsigned ix = 0; ix < order.size(); ++ix) {
+                    auto & e = _entries[order[ix]];
+                    GLint x, y;
+                    if(!find_space(e.region.width, e.region.height, x, y)) {
+                        e.alive = false; --_alive; continue;
+                    }
+                    if(x!=e.region.x || y!=e.region.y) {
+                        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, x, y, e.region.x, e.region.y,
+                                            e.region.width, e.region.height); glCheckError();
+                    }
+                    e.region.x = x; e.region.y = y;
+                    update_uvs(e.region);
+                }
+                gl_texture::unuse();
+            }
+            scratch.del();
+            _holes = false;
+            ++_generation;
+        }
+
+        /**
+         * remove all images
+         */
+        void clear() {
+            _shelves.clear(); _entries.clear();
+            _next_shelf_y = 0; _alive = 0; _holes = false; ++_generation;
+        }
+
+        /**
+         * a counter, that changes whenever regions move
+         */
+        unsigned generation() const { return _generation; }
+        unsigned size() const { return _alive; }
+        /**
+         * @return a non-owning copy of the atlas texture
+         */
+        const gl_texture & texture() const { return _texture; }
+    };
+
+}
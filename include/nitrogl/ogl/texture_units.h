@@ -0,0 +1,168 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "debug.h"
+
+namespace nitrogl {
+
+    /**
+     * Texture units manager of an OpenGL context:
+     * 1. Assigns texture units per draw. `begin_draw()` starts a draw (samplers call it
+     *    before uploading uniforms), then every texture of the draw gets a unit, that no other
+     *    texture of the draw has. The unit, that a texture is already bound to, is preferred,
+     *    so sampler2D uniforms and bindings rarely change between draws. Unit 0 is never
+     *    assigned and is left as a scratch unit (uploads, copies, backdrop).
+     * 2. Tracks the active unit and the bound texture of each unit, so redundant
+     *    glActiveTexture/glBindTexture calls are skipped.
+     *
+     * Notes:
+     * - gl_texture and gl_texture_array bind through `current()`. If you bind textures with raw
+     *   OpenGL calls, call `invalidate()` afterwards.
+     * - `current()` is a per-thread instance, which fits the usual one context per thread. If
+     *   you switch contexts on a thread, keep a `texture_units` per context and `make_current` it.
+     */
+    class texture_units {
+    public:
+        static constexpr GLint max_tracked_units = 32;
+        static constexpr GLuint unknown = ~GLuint(0);
+
+    private:
+        GLint _units; // units count, queried lazily
+        GLint _active;
+        unsigned long _clock;
+        GLuint _bound[2][max_tracked_units]; // bound texture per target per unit
+        unsigned long _draw; // the current draw
+        unsigned long _claims[max_tracked_units]; // the draw, that last claimed a unit
+        GLuint _owners[max_tracked_units]; // the texture, that claimed a unit
+        unsigned long _stamps[max_tracked_units];
+
+        static int target_index(GLenum target) {
+#ifdef GL_TEXTURE_2D_ARRAY
+            if(target==GL_TEXTURE_2D_ARRAY) return 1;
+#endif
+            return target==GL_TEXTURE_2D ? 0 : -1;
+        }
+        static texture_units *& current_pointer() {
+            static thread_local texture_units * units = nullptr;
+            return units;
+        }
+
+    public:
+        texture_units() : _units(-1), _active(-1), _clock(0), _draw(1) {
+            for (GLint ix = 0; ix < max_tracked_units; ++ix) {
+                _claims[ix]=0; _owners[ix]=0; _stamps[ix]=0;
+            }
+            invalidate();
+        }
+
+        /**
+         * the texture units of the current context (per thread by default)
+         */
+        static texture_units & current() {
+            auto * units = current_pointer();
+            if(units) return *units;
+            static thread_local texture_units default_units;
+            return default_units;
+        }
+        /**
+         * use your own units manager for the current context, nullptr restores the default
+         */
+        static void make_current(texture_units * units) { current_pointer()=units; }
+
+        GLint units() {
+            if(_units<0) {
+                GLint max=0;
+                glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max); glCheckError();
+                _units = max<max_tracked_units ? max : max_tracked_units;
+            }
+            return _units;
+        }
+
+        /**
+         * forget the bound state, for example after binding textures with raw OpenGL calls
+         */
+        void invalidate() {
+            _active = -1;
+            for (GLint ix = 0; ix < max_tracked_units; ++ix)
+                _bound[0][ix] = _bound[1][ix] = unknown;
+        }
+
+        /**
+         * start a new draw, units claimed by the previous draw are free again
+         */
+        void begin_draw() { ++_draw; }
+
+        /**
+         * @return a unit for a texture of the current draw. The texture keeps the unit until
+         *         the draw ends. Among the units, that are free in this draw, the unit the
+         *         texture is bound to is preferred, otherwise the least recently used one.
+         *         0 is returned if a draw uses more textures than units.
+         */
+        GLint unit_for(GLenum target, GLuint id) {
+            const GLint count = units();
+            const int t = target_index(target);
+            GLint bound = -1, lru = -1;
+            for (GLint ix = 1; ix < count; ++ix) {
+                if(_claims[ix]==_draw) {
+                    if(_owners[ix]==id) return ix;
+                    continue;
+                }
+                if(bound<0 && t>=0 && _bound[t][ix]==id) bound = ix;
+                if(lru<0 || _stamps[ix]<_stamps[lru]) lru = ix;
+            }
+            const GLint unit = bound>=0 ? bound : lru;
+            if(unit<0) return 0;
+            _claims[unit]=_draw; _owners[unit]=id; _stamps[unit]=++_clock;
+            return unit;
+        }
+
+        void activate(GLint unit) {
+            if(unit==_active) return;
+            glActiveTexture(GL_TEXTURE0 + (unsigned int)unit); glCheckError();
+            _active = unit;
+        }
+
+        /**
+         * bind a texture to a unit, skipped if it is already bound there
+         */
+        void bind(GLenum target, GLuint id, GLint unit) {
+            activate(unit);
+            const int t = target_index(target);
+            const bool tracked = t>=0 && unit>=0 && unit<max_tracked_units;
+            if(tracked && _bound[t][unit]==id) return;
+            glBindTexture(target, id); glCheckError();
+            if(tracked) _bound[t][unit] = id;
+        }
+
+        /**
+         * unbind a target of the active unit
+         */
+        void unbind(GLenum target) {
+            if(_active<0) { glBindTexture(target, 0); glCheckError(); return; }
+            bind(target, 0, _active);
+        }
+
+        /**
+         * forget a texture, call it when deleting a texture, deleted textures
+         * are unbound by OpenGL
+         */
+        void forget(GLuint id) {
+            if(!id) return;
+            for (GLint ix = 0; ix < max_tracked_units; ++ix) {
+                if(_bound[0][ix]==id) _bound[0][ix]=0;
+                if(_bound[1][ix]==id) _bound[1][ix]=0;
+                if(_owners[ix]==id) { _owners[ix]=0; _claims[ix]=0; }
+            }
+        }
+    };
+
+}
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "debug.h"
+#include "vertex_attribs_cache.h"
 
 namespace nitrogl {
 
@@ -48,7 +49,15 @@ namespace nitrogl {
             glBufferSubData(GL_ARRAY_BUFFER, offset, size_bytes, array); glCheckError();
         }
         GLuint id() const { return _id; }
-        void del() { if(_id && owner) { glDeleteBuffers(1, &_id); glCheckError(); _id=0; } }
+        void del() {
+            if(_id && owner) {
+                glDeleteBuffers(1, &_id); glCheckError();
+#ifndef NITROGL_SUPPORTS_VAO
+                vertex_attribs_cache::forget_buffer(_id);
+#endif
+                _id=0;
+            }
+        }
         void bind() const { glBindBuffer(GL_ARRAY_BUFFER, _id); glCheckError(); }
         static void unbind() { glBindBuffer(GL_ARRAY_BUFFER, 0); glCheckError(); }
     };
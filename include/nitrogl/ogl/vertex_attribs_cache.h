@@ -0,0 +1,117 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "gva.h"
+#include "debug.h"
+
+namespace nitrogl {
+
+    /**
+     * Software VAO emulation for contexts without VAO (GL2/ES2). It mirrors the enabled
+     * generic vertex attribute arrays and their pointers, so render nodes re-specify only
+     * what changed since the previous draw, instead of pointing every attribute and then
+     * disabling all the arrays after each draw.
+     *
+     * NOTES:
+     * - Without VAO, attribute arrays are context state, so the mirror is shared by all the
+     *   render nodes. Arrays stay enabled between draws.
+     * - Call `invalidate()` after foreign code changed vertex attribute state, or when
+     *   switching between contexts.
+     * - Deleting a buffer resets the pointers to it, vbo_t reports it with `forget_buffer`.
+     */
+    class vertex_attribs_cache {
+    public:
+        static constexpr unsigned max_attribs = 16;
+
+    private:
+        struct record_t {
+            const void * offset;
+            GLuint vbo;
+            GLenum type;
+            GLsizei stride;
+            GLuint size;
+            GLboolean normalized;
+            bool pointed;
+            bool enabled;
+        };
+        struct state_t {
+            record_t records[max_attribs];
+        };
+
+        static state_t & state() {
+            static state_t s{};
+            return s;
+        }
+
+        static bool same_pointer(const record_t & r, const generic_vertex_attrib_t & a) {
+            return r.pointed && r.vbo==a.vbo && r.type==a.type && r.size==a.size &&
+                   r.stride==a.stride && r.offset==a.offset && r.normalized==a.normalized;
+        }
+
+    public:
+        /**
+         * make the context state: arrays in `enabled_mask` (bit per attribute index) are enabled
+         * and pointed by `gva`, all the other arrays are disabled. Float attributes only.
+         * @param gva generic vertex attributes, indices are below `max_attribs`
+         * @param length length of gva
+         * @param enabled_mask bit (1<<index) enables the array of an attribute, that is in gva
+         */
+        static void apply(const generic_vertex_attrib_t * gva, unsigned length, unsigned enabled_mask) {
+            auto & records = state().records;
+            GLuint bound_vbo = 0; bool bound = false;
+            for (auto * it = gva; it < gva + length; ++it) {
+                const auto index = GLuint(it->index);
+                if(!(enabled_mask & (1u<<index))) continue;
+                auto & r = records[index];
+                if(!same_pointer(r, *it)) {
+                    // bind only when a pointer actually changes
+                    if(!bound || bound_vbo!=it->vbo) {
+                        glBindBuffer(GL_ARRAY_BUFFER, it->vbo); glCheckError();
+                        bound_vbo = it->vbo; bound = true;
+                    }
+                    glVertexAttribPointer(index, GLint(it->size), it->type, it->normalized,
+                                          it->stride, it->offset); glCheckError();
+                    r = { it->offset, it->vbo, it->type, it->stride, it->size,
+                          it->normalized, true, r.enabled };
+                }
+                if(!r.enabled) { glEnableVertexAttribArray(index); glCheckError(); r.enabled = true; }
+            }
+            for (GLuint index = 0; index < max_attribs; ++index) {
+                auto & r = records[index];
+                if(!r.enabled || (enabled_mask & (1u<<index))) continue;
+                glDisableVertexAttribArray(index); glCheckError();
+                r.enabled = false;
+            }
+        }
+
+        /**
+         * a buffer was deleted, GL resets the attribute pointers to it
+         */
+        static void forget_buffer(GLuint vbo) {
+            auto & records = state().records;
+            for (unsigned ix = 0; ix < max_attribs; ++ix)
+                if(records[ix].vbo==vbo) records[ix].pointed = false;
+        }
+
+        /**
+         * disable all the arrays and forget the mirrored state
+         */
+        static void invalidate() {
+            auto & records = state().records;
+            for (GLuint index = 0; index < max_attribs; ++index) {
+                glDisableVertexAttribArray(index); glCheckError();
+                records[index] = record_t{};
+            }
+        }
+    };
+
+}
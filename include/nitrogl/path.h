@@ -24,8 +24,10 @@ namespace nitrogl {
      * Path alias (float point version)
      * @tparam container_template_type the container template type
      * @tparam Allocator the memory allocator for the container and tessellation
+     * @tparam output_index type of the tessellation indices, unsigned int or unsigned short
      */
     template <template<typename...> class container_template_type=dynamic_array,
-              class Allocator=nitrogl::std_rebind_allocator<>>
-    using path = microtess::path<float, container_template_type, Allocator>;
+              class Allocator=nitrogl::std_rebind_allocator<>,
+              typename output_index=unsigned int>
+    using path = microtess::path<float, container_template_type, Allocator, output_index>;
 }
\ No newline at end of file
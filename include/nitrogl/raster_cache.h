@@ -0,0 +1,305 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "canvas.h"
+#include "ogl/texture_atlas.h"
+#include "samplers/texture_region_sampler.h"
+#include "samplers/color_sampler.h"
+
+namespace nitrogl {
+
+    /**
+     * An opt-in raster cache for static vector content, that is drawn every frame.
+     * Draw through the cache instead of the canvas:
+     *      cache.begin_frame();
+     *      cache.drawPathFill(canvas, sampler, path, rule, quality, transform);
+     *
+     * - Every draw is keyed by (geometry hash, sampler hash, scale bucket, uv mapping). The scale
+     *   bucket is the quantized linear part of the transform, so only translations can differ.
+     * - After a key was drawn for `frames_threshold` consecutive frames, it is rendered once
+     *   into an atlas texture. Later draws are a single textured quad, that is translated by the
+     *   translation difference of the transforms.
+     * - The atlas (and it's backdrop) fit in a memory budget, least recently used rasters are
+     *   evicted, when the atlas is full.
+     *
+     * Notes:
+     * - Sampler hash codes do not include uniforms (colors, stops, etc..). If the uniforms
+     *   of a sampler change, pass a different `user_key` or call `clear()`.
+     * - The geometry hash reads the tessellated vertices, that paths cache anyway, so it is
+     *   cheap compared to uploading and shading the geometry.
+     * - Cached quads are filtered linearly, so sub-pixel translations are slightly softer.
+     * @tparam Allocator allocator for the internal book-keeping
+     */
+    template<class Allocator=nitrogl::std_rebind_allocator<>>
+    class raster_cache {
+        using uintptr_type = nitrogl::uintptr_type;
+        using murmur_t = microc::iterative_murmur<uintptr_type>;
+
+        struct entry_t {
+            uintptr_type key;
+            unsigned long first_frame, last_frame; // range of consecutive frames
+            unsigned region_id;
+            bool rasterized, uncacheable;
+            float left, top; // where the raster was drawn in canvas coordinates
+            float tx, ty; // translation of the transform of the raster
+        };
+        using entries_allocator_t = typename Allocator::template rebind<entry_t>::other;
+
+        texture_atlas<Allocator> _atlas;
+        canvas _canvas; // draws into the atlas
+        dynamic_array<entry_t, entries_allocator_t> _entries;
+        unsigned _max_entries;
+        unsigned _frames_threshold;
+        unsigned long _frame;
+        unsigned long _hits, _misses;
+
+        static GLsizei atlas_size_for(unsigned long memory_budget) {
+            // the atlas and the backdrop of it's canvas, 4 bytes per pixel each
+            GLsizei size = 64;
+            while((unsigned long)(size*2)*(size*2)*8 <= memory_budget) size*=2;
+            return size;
+        }
+        static uintptr_type bits(float value) {
+            union { float f; uint32_t u; } v; v.f=value;
+            return uintptr_type(v.u);
+        }
+        static uintptr_type bucket(float value) {
+            // 1/1024 resolution
+            const float v = value*1024.0f;
+            return uintptr_type(intptr_t(v<0.0f ? v-0.5f : v+0.5f));
+        }
+        static int floor_int(float v) { const int i = int(v); return float(i)>v ? i-1 : i; }
+        static int ceil_int(float v) { const int i = int(v); return float(i)<v ? i+1 : i; }
+
+        template<class indices_type>
+        static void hash_indices(murmur_t & murmur, const indices_type & indices) {
+            murmur.next(uintptr_type(indices.size()));
+            for (unsigned ix = 0; ix < indices.size(); ++ix)
+                murmur.next(uintptr_type(indices[ix]));
+        }
+        template<class buffers_type>
+        static void hash_geometry(murmur_t & murmur, const buffers_type & buffers) {
+            const auto & vertices = buffers.output_vertices;
+            murmur.next(uintptr_type(buffers.output_indices_type));
+            murmur.next(uintptr_type(vertices.size()));
+            for (unsigned ix = 0; ix < vertices.size(); ++ix) {
+                murmur.next(bits(vertices[ix].x));
+                murmur.next(bits(vertices[ix].y));
+            }
+            if(buffers.are_indices_wide()) hash_indices(murmur, buffers.output_wide_indices);
+            else hash_indices(murmur, buffers.output_indices);
+        }
+        template<class buffers_type>
+        static rectf geometry_bbox(const buffers_type & buffers) {
+            const auto & vertices = buffers.output_vertices;
+            if(buffers.are_indices_wide())
+                return triangles::triangles_bbox(vertices.data(), vertices.size(),
+                                                 buffers.output_wide_indices.data(),
+                                                 buffers.output_wide_indices.size());
+            return triangles::triangles_bbox(vertices.data(), vertices.size(),
+                                             buffers.output_indices.data(),
+                                             buffers.output_indices.size());
+        }
+        static void hash_mapping(murmur_t & murmur, const sampler_t & sampler,
+                                 const mat3f & transform, const mat3f & transform_uv,
+                                 float u0, float v0, float u1, float v1, unsigned user_key) {
+            murmur.next(sampler.hash_code());
+            // scale bucket, the linear part of the transform
+            murmur.next(bucket(transform(0,0))); murmur.next(bucket(transform(0,1)));
+            murmur.next(bucket(transform(1,0))); murmur.next(bucket(transform(1,1)));
+            for (unsigned ix = 0; ix < 9; ++ix) murmur.next(bucket(transform_uv[ix]));
+            murmur.next(bucket(u0)); murmur.next(bucket(v0));
+            murmur.next(bucket(u1)); murmur.next(bucket(v1));
+            murmur.next(uintptr_type(user_key));
+        }
+
+        entry_t & entry_of(uintptr_type key) {
+            for (unsigned ix = 0; ix < _entries.size(); ++ix)
+                if(_entries[ix].key==key) return _entries[ix];
+            if(_entries.size()>=_max_entries) {
+                // reuse the least recently drawn entry
+                unsigned lru = 0;
+                for (unsigned ix = 1; ix < _entries.size(); ++ix)
+                    if(_entries[ix].last_frame<_entries[lru].last_frame) lru = ix;
+                auto & e = _entries[lru];
+                if(e.rasterized) _atlas.remove(e.region_id);
+                e = { key, _frame, _frame, 0, false, false, 0.0f, 0.0f, 0.0f, 0.0f };
+                return e;
+            }
+            _entries.push_back({ key, _frame, _frame, 0, false, false, 0.0f, 0.0f, 0.0f, 0.0f });
+            return _entries[_entries.size()-1];
+        }
+
+        /**
+         * @param draw draws the content into a canvas, (canvas &, const mat3f & transform, float opacity)
+         */
+        template<class draw_function>
+        void draw_cached(canvas & target, uintptr_type key, const rectf & bbox,
+                         const mat3f & transform, float opacity, const draw_function & draw) {
+            auto & e = entry_of(key);
+            if(e.last_frame+1 < _frame) e.first_frame = _frame; // streak was broken
+            e.last_frame = _frame;
+            const float tx = transform(0,2), ty = transform(1,2);
+            if(e.rasterized && !_atlas.contains(e.region_id)) e.rasterized = false; // evicted
+            if(!e.rasterized && !e.uncacheable && _frame-e.first_frame+1>=_frames_threshold)
+                rasterize(e, bbox, transform, draw);
+            if(!e.rasterized) {
+                ++_misses;
+                draw(target, transform, opacity);
+                return;
+            }
+            ++_hits;
+            const auto region = _atlas.region(e.region_id);
+            texture_region_sampler sampler{_atlas.texture(), region.u0, region.v0, region.u1, region.v1};
+            const float left = e.left + tx - e.tx, top = e.top + ty - e.ty;
+            target.drawRect(sampler, left, top, left + float(region.width), top + float(region.height),
+                            opacity);
+        }
+
+        template<class draw_function>
+        void rasterize(entry_t & e, const rectf & bbox, const mat3f & transform,
+                       const draw_function & draw) {
+            // canvas transforms geometry about the top-left of it's bounding box
+            const float a=transform(0,0), b=transform(0,1), c=transform(1,0), d=transform(1,1);
+            const float tx = transform(0,2), ty = transform(1,2);
+            const float xs[2] = { 0.0f, bbox.right-bbox.left }, ys[2] = { 0.0f, bbox.bottom-bbox.top };
+            float l=0, t=0, r=0, btm=0;
+            for (unsigned ix = 0; ix < 4; ++ix) {
+                const float x = bbox.left + a*xs[ix&1] + b*ys[ix>>1] + tx;
+                const float y = bbox.top + c*xs[ix&1] + d*ys[ix>>1] + ty;
+                if(ix==0 || x<l) { l=x; }
+                if(ix==0 || x>r) { r=x; }
+                if(ix==0 || y<t) { t=y; }
+                if(ix==0 || y>btm) { btm=y; }
+            }
+            const int L = floor_int(l), T = floor_int(t);
+            const int W = ceil_int(r) - L, H = ceil_int(btm) - T;
+            const GLsizei max_size = _atlas.texture().width()/2;
+            if(W<=0 || H<=0 || W>max_size || H>max_size) { e.uncacheable = true; return; }
+            const auto region = _atlas.reserve(W, H, true);
+            if(!region.valid()) return;
+            // texture rows go up, canvas rows go down
+            const float x = float(region.x), y = float(_atlas.texture().height() - region.y - H);
+            color_sampler transparent{0.0f, 0.0f, 0.0f, 0.0f};
+            _canvas.update_composition(blend_modes::Normal(), porter_duff::Copy());
+            _canvas.drawRect(transparent, x, y, x + float(W), y + float(H));
+            _canvas.update_composition(blend_modes::Normal(), porter_duff::SourceOver());
+            mat3f moved = transform;
+            moved(0,2) = tx + x - float(L); moved(1,2) = ty + y - float(T);
+            draw(_canvas, moved, 1.0f);
+            e.region_id = region.id; e.rasterized = true;
+            e.left = float(L); e.top = float(T); e.tx = tx; e.ty = ty;
+        }
+
+    public:
+        /**
+         * @param memory_budget bytes for the atlas texture and it's canvas backdrop
+         * @param frames_threshold after how many consecutive frames a draw is rasterized
+         * @param max_entries how many draws are tracked
+         */
+        explicit raster_cache(unsigned long memory_budget=1u<<23, unsigned frames_threshold=3,
+                              unsigned max_entries=128, const Allocator & allocator=Allocator()) :
+                _atlas(atlas_size_for(memory_budget), atlas_size_for(memory_budget), 1, true, allocator),
+                _canvas(_atlas.texture()), _entries(entries_allocator_t(allocator)),
+                _max_entries(max_entries), _frames_threshold(frames_threshold ? frames_threshold : 1),
+                _frame(1), _hits(0), _misses(0) {
+            _canvas.clear(0.0f, 0.0f, 0.0f, 0.0f);
+        }
+        raster_cache(const raster_cache &)=delete;
+        raster_cache & operator=(const raster_cache &)=delete;
+
+        /**
+         * call once per frame, before drawing
+         */
+        void begin_frame() { ++_frame; }
+
+        /**
+         * same as `canvas::drawPathFill`, through the cache
+         * @param target the canvas to draw into
+         * @param user_key mix it into the key, when the uniforms of the sampler change
+         */
+        template <template<typename...> class path_container_template,
+                  class tessellation_allocator, typename path_index>
+        void drawPathFill(canvas & target, const sampler_t & sampler,
+                          microtess::path<float, path_container_template, tessellation_allocator, path_index> & path,
+                          const microtess::fill_rule &rule,
+                          const microtess::tess_quality &quality,
+                          const mat3f & transform = mat3f::identity(),
+                          const mat3f & transform_uv = mat3f::identity(),
+                          float opacity=1.0f,
+                          float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f,
+                          unsigned user_key=0) {
+            const auto & buffers = path.tessellateFill(rule, quality, false, false);
+            if(buffers.output_vertices.size()==0) return;
+            murmur_t murmur;
+            murmur.begin(1);
+            murmur.next(uintptr_type(rule)); murmur.next(uintptr_type(quality));
+            hash_geometry(murmur, buffers);
+            hash_mapping(murmur, sampler, transform, transform_uv, u0, v0, u1, v1, user_key);
+            const auto bbox = geometry_bbox(buffers);
+            draw_cached(target, murmur.end(), bbox, transform, opacity,
+                        [&](canvas & c, const mat3f & t, float o) {
+                c.drawPathFill(sampler, path, rule, quality, t, transform_uv, o, u0, v0, u1, v1);
+            });
+        }
+
+        /**
+         * same as `canvas::drawPathStroke`, through the cache
+         * @param target the canvas to draw into
+         * @param user_key mix it into the key, when the uniforms of the sampler change
+         */
+        template <class Iterable, template<typename...> class path_container_template,
+                  class tessellation_allocator, typename path_index>
+        void drawPathStroke(canvas & target, const sampler_t & sampler,
+                            microtess::path<float, path_container_template, tessellation_allocator, path_index> & path,
+                            float stroke_width=1.0f,
+                            microtess::stroke_cap cap=microtess::stroke_cap::butt,
+                            microtess::stroke_line_join line_join=microtess::stroke_line_join::bevel,
+                            const int miter_limit=4,
+                            const Iterable & stroke_dash_array={},
+                            int stroke_dash_offset=0,
+                            const mat3f & transform = mat3f::identity(),
+                            const mat3f & transform_uv = mat3f::identity(),
+                            float opacity=1.0f,
+                            float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f,
+                            unsigned user_key=0) {
+            const auto & buffers = path.template tessellateStroke<Iterable>(
+                    stroke_width, cap, line_join, miter_limit, stroke_dash_array, stroke_dash_offset);
+            if(buffers.output_vertices.size()==0) return;
+            murmur_t murmur;
+            murmur.begin(2);
+            hash_geometry(murmur, buffers);
+            hash_mapping(murmur, sampler, transform, transform_uv, u0, v0, u1, v1, user_key);
+            const auto bbox = geometry_bbox(buffers);
+            draw_cached(target, murmur.end(), bbox, transform, opacity,
+                        [&](canvas & c, const mat3f & t, float o) {
+                c.template drawPathStroke<Iterable>(sampler, path, stroke_width, cap, line_join,
+                                                    miter_limit, stroke_dash_array, stroke_dash_offset,
+                                                    t, transform_uv, o, u0, v0, u1, v1);
+            });
+        }
+
+        /**
+         * forget all the rasters
+         */
+        void clear() {
+            _atlas.clear();
+            _entries.clear();
+        }
+
+        unsigned long hits() const { return _hits; }
+        unsigned long misses() const { return _misses; }
+        unsigned size() const { return _atlas.size(); }
+        const texture_atlas<Allocator> & atlas() const { return _atlas; }
+    };
+
+}
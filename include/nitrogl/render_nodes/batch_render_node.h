@@ -0,0 +1,356 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "../_internal/ogl_info.h"
+
+#ifdef NITROGL_SUPPORTS_BATCHING
+
+#include "../ogl/shader_program.h"
+#include "../ogl/vao.h"
+#include "../ogl/vbo.h"
+#include "../ogl/ebo.h"
+#include "../ogl/texture_units.h"
+#include "../_internal/main_shader_program.h"
+#include "../samplers/sampler.h"
+#include "../math.h"
+
+namespace nitrogl {
+
+    /**
+     * Draws many meshes, that share a program and sampler, with a few draw calls.
+     * 1. The vertices and indices of all the draws are streamed into shared buffers, indices
+     *    are not rebased, each draw starts at it's own base vertex.
+     * 2. Per draw data (model transform, uvs transform, opacity, bbox) is streamed into a
+     *    texture buffer, which the batched vertex shader variant fetches by a draw id.
+     * 3. With gl>=4.3, the draws are submitted with a single glMultiDrawElementsIndirect. The
+     *    draw id is an instanced attribute, that is offset by the base instance of each
+     *    command, so ARB_shader_draw_parameters (gl_DrawID) is not required.
+     *    Otherwise, the draw id is a vertex attribute, and the draws are submitted with
+     *    glMultiDrawElementsBaseVertex (gl-es has no multi draws, so a draw call per draw).
+     *
+     * Notes:
+     * - all the draws have uvs or none of them has, draws without uvs require a program of
+     *   the generated uvs variant, see main_shader_program.
+     * - batches are split by the size limit of texture buffers
+     */
+    class batch_render_node {
+
+    public:
+        using program_type = main_shader_program;
+        using size_type = GLsizeiptr;
+        // texels (RGBA32F) of per draw data
+        static constexpr size_type TEXELS = 7;
+
+        /**
+         * geometry of a draw
+         */
+        struct draw_type {
+            const vec2f * pos;
+            // null uvs require a program of the generated uvs variant
+            const vec2f * uvs;
+            // null indices draw the vertices in order
+            const GLuint * indices;
+            size_type pos_size;
+            size_type indices_size;
+        };
+
+        /**
+         * per draw data
+         */
+        struct draw_data_type {
+            mat3f transform;
+            mat3f transform_uvs;
+            float opacity;
+            rectf bbox;
+        };
+
+        /**
+         * shared data of all the draws of a batch
+         */
+        struct data_type {
+            GLenum triangles_type;
+            bool has_uvs;
+            const mat4f & mat_view;
+            const mat4f & mat_proj;
+            const gl_texture & backdrop_texture;
+            const GLuint window_width;
+            const GLuint window_height;
+        };
+
+        struct GVA {
+            GVA()=default;
+            static constexpr unsigned SIZE = 4;
+            static constexpr unsigned size() { return SIZE; }
+            nitrogl::generic_vertex_attrib_t data[SIZE];
+        };
+
+    private:
+        GVA gva{};
+        vbo_t _vbo_pos{}, _vbo_uvs{}, _vbo_draw_ids{};
+        // storage of the per draw data texture buffer, and of the indirect commands
+        vbo_t _vbo_draws{}, _vbo_commands{};
+        vao_t _vao{};
+        ebo_t _ebo{};
+        GLuint _tex_draws=0;
+        size_type _max_draws=0;
+
+        /**
+         * orphan a buffer and map it for writing
+         */
+        static void * map_for_write(GLuint buffer, size_type bytes) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            void * memory = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bytes,
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            glCheckError();
+            return memory;
+        }
+        /**
+         * @return false if the content of the buffer was lost while it was mapped
+         */
+        static bool unmap(GLuint buffer) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            const bool intact = glUnmapBuffer(GL_COPY_WRITE_BUFFER)==GL_TRUE;
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0); glCheckError();
+            return intact;
+        }
+
+        static bool is_indexed(const draw_type & draw) {
+            return draw.indices!=nullptr && draw.indices_size!=0;
+        }
+
+        /**
+         * stream the draws [start, end) and submit them
+         */
+        template<class draws_source>
+        void render_range(const data_type & d, const draws_source & draws,
+                          size_type start, size_type end) const {
+            const size_type count = end-start;
+            size_type vertices_count = 0, indices_count = 0;
+            for (size_type ix = start; ix < end; ++ix) {
+                const draw_type draw = draws.geometry(ix);
+                vertices_count += draw.pos_size;
+                indices_count += is_indexed(draw) ? draw.indices_size : draw.pos_size;
+            }
+            if(vertices_count==0) return;
+
+            auto * pos = static_cast<vec2f *>(map_for_write(_vbo_pos.id(),
+                                                            vertices_count*size_type(sizeof(vec2f))));
+            auto * uvs = d.has_uvs ? static_cast<vec2f *>(map_for_write(_vbo_uvs.id(),
+                                            vertices_count*size_type(sizeof(vec2f)))) : nullptr;
+#ifdef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+            // a draw id per draw, selected by the base instance of the commands
+            auto * ids = static_cast<GLfloat *>(map_for_write(_vbo_draw_ids.id(),
+                                                              count*size_type(sizeof(GLfloat))));
+            // {count, instance count, first index, base vertex, base instance}
+            auto * commands = static_cast<GLuint *>(map_for_write(_vbo_commands.id(),
+                                                                  count*5*size_type(sizeof(GLuint))));
+#else
+            // a draw id per vertex
+            auto * ids = static_cast<GLfloat *>(map_for_write(_vbo_draw_ids.id(),
+                                                        vertices_count*size_type(sizeof(GLfloat))));
+#endif
+            auto * elements = static_cast<GLuint *>(map_for_write(_ebo.id(),
+                                                        indices_count*size_type(sizeof(GLuint))));
+            auto * texels = static_cast<GLfloat *>(map_for_write(_vbo_draws.id(),
+                                                        count*TEXELS*4*size_type(sizeof(GLfloat))));
+
+            bool mapped = pos && (uvs || !d.has_uvs) && ids && elements && texels;
+#ifdef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+            mapped = mapped && commands;
+#endif
+            size_type first_index = 0, base_vertex = 0;
+            for (size_type ix = start; mapped && ix < end; ++ix) {
+                const draw_type draw = draws.geometry(ix);
+                const draw_data_type data = draws.resolve(ix);
+                const auto id = GLuint(ix-start);
+                const size_type draw_indices = is_indexed(draw) ? draw.indices_size : draw.pos_size;
+                for (size_type jx = 0; jx < draw.pos_size; ++jx) {
+                    pos[base_vertex+jx] = draw.pos[jx];
+                    if(uvs) uvs[base_vertex+jx] = draw.uvs ? draw.uvs[jx] : vec2f(0.0f, 0.0f);
+#ifndef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+                    ids[base_vertex+jx] = GLfloat(id);
+#endif
+                }
+                for (size_type jx = 0; jx < draw_indices; ++jx)
+                    elements[first_index+jx] = is_indexed(draw) ? draw.indices[jx] : GLuint(jx);
+                // model and uvs transform columns, the opacity rides on the first column
+                GLfloat * t = texels + id*TEXELS*4;
+                const float * m = data.transform.data();
+                const float * u = data.transform_uvs.data();
+                for (int c = 0; c < 3; ++c) {
+                    t[c*4+0]=m[c*3+0]; t[c*4+1]=m[c*3+1]; t[c*4+2]=m[c*3+2]; t[c*4+3]=0.0f;
+                    t[12+c*4+0]=u[c*3+0]; t[12+c*4+1]=u[c*3+1]; t[12+c*4+2]=u[c*3+2]; t[12+c*4+3]=0.0f;
+                }
+                t[3] = data.opacity;
+                t[24] = data.bbox.left; t[25] = data.bbox.top;
+                t[26] = data.bbox.width(); t[27] = data.bbox.height();
+#ifdef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+                ids[id] = GLfloat(id);
+                GLuint * command = commands + id*5;
+                command[0] = GLuint(draw_indices); command[1] = 1;
+                command[2] = GLuint(first_index); command[3] = GLuint(base_vertex);
+                command[4] = id;
+#endif
+                first_index += draw_indices;
+                base_vertex += draw.pos_size;
+            }
+
+            // buffers, that failed to map, are not mapped and must not be unmapped
+            if(pos) mapped = unmap(_vbo_pos.id()) && mapped;
+            if(uvs) mapped = unmap(_vbo_uvs.id()) && mapped;
+            if(ids) mapped = unmap(_vbo_draw_ids.id()) && mapped;
+            if(elements) mapped = unmap(_ebo.id()) && mapped;
+            if(texels) mapped = unmap(_vbo_draws.id()) && mapped;
+#ifdef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+            if(commands) mapped = unmap(_vbo_commands.id()) && mapped;
+#endif
+            if(!mapped) return;
+
+            _vao.bind();
+            if(d.has_uvs) glEnableVertexAttribArray(GLuint(gva.data[1].index));
+            else glDisableVertexAttribArray(GLuint(gva.data[1].index));
+            glCheckError();
+#ifdef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _vbo_commands.id());
+            glMultiDrawElementsIndirect(d.triangles_type, GL_UNSIGNED_INT, OFFSET(0),
+                                        GLsizei(count), 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            glCheckError();
+#else
+            // the draw calls arguments, in stack chunks
+            static constexpr size_type CHUNK = 256;
+            GLsizei counts[CHUNK]; const void * offsets[CHUNK]; GLint base_vertices[CHUNK];
+            first_index = 0; base_vertex = 0;
+            for (size_type chunk = start; chunk < end; chunk+=CHUNK) {
+                const size_type chunk_end = chunk+CHUNK<end ? chunk+CHUNK : end;
+                for (size_type ix = chunk; ix < chunk_end; ++ix) {
+                    const draw_type draw = draws.geometry(ix);
+                    const size_type draw_indices = is_indexed(draw) ? draw.indices_size : draw.pos_size;
+                    counts[ix-chunk] = GLsizei(draw_indices);
+                    offsets[ix-chunk] = OFFSET(first_index*size_type(sizeof(GLuint)));
+                    base_vertices[ix-chunk] = GLint(base_vertex);
+                    first_index += draw_indices;
+                    base_vertex += draw.pos_size;
+                }
+#ifdef NITROGL_OPEN_GL_ES
+                for (size_type ix = 0; ix < chunk_end-chunk; ++ix)
+                    glDrawElementsBaseVertex(d.triangles_type, counts[ix], GL_UNSIGNED_INT,
+                                             offsets[ix], base_vertices[ix]);
+#else
+                glMultiDrawElementsBaseVertex(d.triangles_type, counts, GL_UNSIGNED_INT,
+                                              offsets, GLsizei(chunk_end-chunk), base_vertices);
+#endif
+                glCheckError();
+            }
+#endif
+            vao_t::unbind();
+        }
+
+    public:
+        batch_render_node()=default;
+        batch_render_node(const batch_render_node &)=delete;
+        batch_render_node & operator=(const batch_render_node &)=delete;
+        ~batch_render_node() {
+            if(_tex_draws) {
+                texture_units::current().forget(_tex_draws);
+                glDeleteTextures(1, &_tex_draws); glCheckError();
+            }
+        }
+
+        void init() {
+            // configure the vao, vbo, generic vertex attribs, non interleaved
+            gva = {{
+                { 0, GL_FLOAT, 2, OFFSET(0), 0, _vbo_pos.id(), GL_FALSE},
+                { 1, GL_FLOAT, 2, OFFSET(0), 0, _vbo_uvs.id(), GL_FALSE},
+                // q is disabled and constant
+                { 2, GL_FLOAT, 1, OFFSET(0), 0, _vbo_pos.id(), GL_FALSE},
+                { 3, GL_FLOAT, 1, OFFSET(0), 0, _vbo_draw_ids.id(), GL_FALSE}
+            }};
+
+            _vao.bind();
+            _ebo.bind();
+            program_type::point_generic_vertex_attributes(gva.data,
+                     program_type::shader_vertex_attributes().data, GVA::size());
+            glDisableVertexAttribArray(GLuint(gva.data[2].index));
+#ifdef NITROGL_SUPPORTS_MULTI_DRAW_INDIRECT
+            glVertexAttribDivisor(GLuint(gva.data[3].index), 1);
+#endif
+            glCheckError();
+            vao_t::unbind();
+
+            // per draw data texture buffer, the buffer has to exist before attaching it
+            glBindBuffer(GL_TEXTURE_BUFFER, _vbo_draws.id());
+            glBufferData(GL_TEXTURE_BUFFER, TEXELS*4*size_type(sizeof(GLfloat)), nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            glGenTextures(1, &_tex_draws);
+            glBindTexture(GL_TEXTURE_BUFFER, _tex_draws);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _vbo_draws.id());
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+            GLint max_texels = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+            glCheckError();
+            _max_draws = size_type(max_texels)/TEXELS;
+            texture_units::current().invalidate();
+        }
+
+        bool wasInitialized() const { return _tex_draws!=0; }
+        /**
+         * the most draws, that fit a single texture buffer, larger batches are split
+         */
+        size_type maxDrawsPerSubmit() const { return _max_draws; }
+
+        /**
+         * @tparam draws_source has `size()`, `geometry(i)` returning a draw_type and `resolve(i)`
+         *         returning a draw_data_type. resolve is called once per draw.
+         */
+        template<class draws_source>
+        void render(const program_type & program, sampler_t & sampler, const data_type & data,
+                    const draws_source & draws) const {
+            const auto & d = data;
+            const size_type count = size_type(draws.size());
+            if(count==0 || _max_draws==0) return;
+
+            program.use();
+            // vertex uniforms, the model and uvs transforms are per draw
+            program.updateViewMatrix(d.mat_view);
+            program.updateProjectionMatrix(d.mat_proj);
+            program_type::updateConstantQ(1.0f);
+
+            // fragment uniforms, the opacity is per draw
+            program.update_window_size(d.window_width, d.window_height);
+            program.updateOpacity(1.0f);
+
+            // sampler uniforms are shared by the batch
+            texture_units::current().begin_draw();
+            sampler.upload_uniforms(program.id());
+            // the backdrop is bound last, to the scratch unit, that sampler uploads may use
+            program.update_backdrop_texture(d.backdrop_texture);
+
+            // the draws texture buffer takes a unit of this draw, like the sampler textures
+            auto & units = texture_units::current();
+            const GLint unit = units.unit_for(GL_TEXTURE_BUFFER, _tex_draws);
+            units.bind(GL_TEXTURE_BUFFER, _tex_draws, unit);
+            program.updateDrawsBuffer(unit);
+
+            for (size_type start = 0; start < count; start+=_max_draws)
+                render_range(d, draws, start, start+_max_draws<count ? start+_max_draws : count);
+
+            // un-use shader
+            shader_program::unuse();
+        }
+
+    };
+
+}
+
+#endif
@@ -13,10 +13,13 @@
 #include "../ogl/shader_program.h"
 #include "../ogl/vao.h"
 #include "../ogl/vbo.h"
+#include "../ogl/vertex_attribs_cache.h"
 #include "../ogl/ebo.h"
 #include "../_internal/main_shader_program.h"
 #include "../samplers/sampler.h"
 #include "../math.h"
+#include "../triangles.h"
+#include "vertex_layout.h"
 
 namespace nitrogl {
 
@@ -27,14 +30,19 @@ namespace nitrogl {
         using size_type = GLsizeiptr;
         struct data_type {
             const vec2f * pos;
+            // null uvs require a program of the generated uvs variant, see main_shader_program
             const vec2f * uvs;
+            // null qs are the constant 1
             const float * qs;
-            const GLuint * indices;
+            // GLuint/GLushort/GLubyte indices, see indices_type
+            const void * indices;
 
             size_type pos_size;
             size_type uvs_size;
             size_type qs_size;
             size_type indices_size;
+            // GL_UNSIGNED_INT indices are narrowed to GL_UNSIGNED_SHORT, when they fit
+            GLenum indices_type;
 
             GLenum triangles_type;
 
@@ -60,6 +68,126 @@ namespace nitrogl {
         vbo_t _vbo_pos{}, _vbo_uvs{}, _vbo_qs{};
         vao_t _vao{};
         ebo_t _ebo{};
+        // compact layouts, a single interleaved vbo, see vertex_layout
+        vertex_layout _layout{};
+        mutable GVA _gva_packed{};
+        mutable vertex_layout _packed_pointed_layout{};
+        mutable int _packed_pointed_uvs{-1};
+        vbo_t _vbo_packed{};
+        vao_t _vao_packed{};
+
+        /**
+         * the selected layout, with components that can not represent the data as floats
+         */
+        vertex_layout fit_layout(const data_type & d) const {
+            vertex_layout layout = _layout;
+            if(layout.position==vertex_layout::position_format::fixed16) {
+                const float limit = 32767.0f/layout.fixed_scale();
+                for (size_type ix = 0; ix < d.pos_size; ++ix) {
+                    const auto & p = d.pos[ix];
+                    if(p.x>=-limit && p.x<=limit && p.y>=-limit && p.y<=limit) continue;
+                    layout.position = vertex_layout::position_format::float32; break;
+                }
+            }
+#ifndef NITROGL_SUPPORTS_HALF_FLOAT_VERTICES
+            if(layout.uv==vertex_layout::uv_format::half16)
+                layout.uv = vertex_layout::uv_format::float32;
+#endif
+            if(layout.uv==vertex_layout::uv_format::unorm16 && d.uvs) {
+                for (size_type ix = 0; ix < d.uvs_size; ++ix) {
+                    const auto & uv = d.uvs[ix];
+                    if(uv.x>=0.0f && uv.x<=1.0f && uv.y>=0.0f && uv.y<=1.0f) continue;
+                    layout.uv = vertex_layout::uv_format::float32; break;
+                }
+            }
+            return layout;
+        }
+
+        static GLushort * put_float(GLushort * out, float value) {
+            union { float f; GLushort h[2]; } v; v.f=value;
+            *out++ = v.h[0]; *out++ = v.h[1];
+            return out;
+        }
+
+        /**
+         * pack the vertices in stack chunks, and stream them into the interleaved vbo
+         */
+        void upload_packed(const vertex_layout & layout, const data_type & d, bool has_uvs) const {
+            using pos_format = vertex_layout::position_format;
+            using uv_format = vertex_layout::uv_format;
+            static constexpr size_type CHUNK = 256;
+            // 16 bytes per vertex at most
+            GLushort chunk[CHUNK*8];
+            const GLsizei stride = layout.position_bytes() + (has_uvs ? layout.uv_bytes() : 0);
+            const float k = layout.fixed_scale();
+            _vbo_packed.uploadData(nullptr, d.pos_size*stride, GL_DYNAMIC_DRAW);
+            for (size_type start = 0; start < d.pos_size; start+=CHUNK) {
+                const size_type end = start+CHUNK<d.pos_size ? start+CHUNK : d.pos_size;
+                GLushort * out = chunk;
+                for (size_type ix = start; ix < end; ++ix) {
+                    const auto & p = d.pos[ix];
+                    if(layout.position==pos_format::fixed16) {
+                        *out++ = GLushort(GLshort(p.x*k + (p.x<0.0f ? -0.5f : 0.5f)));
+                        *out++ = GLushort(GLshort(p.y*k + (p.y<0.0f ? -0.5f : 0.5f)));
+                    } else { out = put_float(out, p.x); out = put_float(out, p.y); }
+                    if(!has_uvs) continue;
+                    const vec2f uv = ix<d.uvs_size ? d.uvs[ix] : vec2f(0.0f, 0.0f);
+                    switch (layout.uv) {
+                        case uv_format::half16:
+                            *out++ = vertex_layout::float_to_half(uv.x);
+                            *out++ = vertex_layout::float_to_half(uv.y);
+                            break;
+                        case uv_format::unorm16:
+                            *out++ = GLushort(uv.x*65535.0f + 0.5f);
+                            *out++ = GLushort(uv.y*65535.0f + 0.5f);
+                            break;
+                        default: out = put_float(out, uv.x); out = put_float(out, uv.y);
+                    }
+                }
+                _vbo_packed.uploadSubData(GLintptr(start*stride), chunk,
+                                          GLuint((out-chunk)*sizeof(GLushort)));
+            }
+        }
+
+        void configure_packed_gva(const vertex_layout & layout, bool has_uvs) const {
+            const GLsizei stride = layout.position_bytes() + (has_uvs ? layout.uv_bytes() : 0);
+            const GLuint vbo = _vbo_packed.id();
+            const GLenum pos_type = layout.position_gl_type();
+            // missing uvs and q arrays are disabled, they still point at the positions,
+            // so every pointer stays within the buffer
+            _gva_packed.data[0] = { 0, pos_type, 2, OFFSET(0), stride, vbo, GL_FALSE };
+            if(has_uvs)
+                _gva_packed.data[1] = { 1, layout.uv_gl_type(), 2, OFFSET(layout.position_bytes()),
+                                        stride, vbo, layout.uv_normalized() };
+            else _gva_packed.data[1] = { 1, pos_type, 2, OFFSET(0), stride, vbo, GL_FALSE };
+            _gva_packed.data[2] = { 2, pos_type, 1, OFFSET(0), stride, vbo, GL_FALSE };
+        }
+
+        void upload_streams(const data_type & d) const {
+            static constexpr auto FLOAT_SIZE = GLsizeiptr (sizeof(float));
+            static constexpr auto VEC2_SIZE = GLsizeiptr (sizeof(vec2f));
+            // missing uvs and qs are not uploaded, their arrays are disabled
+            _vbo_pos.uploadData(d.pos, d.pos_size*VEC2_SIZE, GL_DYNAMIC_DRAW);
+            if(d.uvs) _vbo_uvs.uploadData(d.uvs, d.uvs_size*VEC2_SIZE, GL_DYNAMIC_DRAW);
+            if(d.qs) _vbo_qs.uploadData(d.qs, d.qs_size*FLOAT_SIZE, GL_DYNAMIC_DRAW);
+        }
+
+        /**
+         * enable the uvs/q arrays of the bound VAO, when they are supplied.
+         * a disabled q is the constant 1, a disabled uvs array is only used by programs,
+         * that generate uvs from the bbox and never read it.
+         */
+        static void enable_optional_arrays(bool has_uvs, bool has_qs) {
+            const auto * sva = program_type::shader_vertex_attributes().data;
+            if(has_uvs) glEnableVertexAttribArray(GLuint(sva[1].location));
+            else glDisableVertexAttribArray(GLuint(sva[1].location));
+            if(has_qs) glEnableVertexAttribArray(GLuint(sva[2].location));
+            else {
+                glDisableVertexAttribArray(GLuint(sva[2].location));
+                program_type::updateConstantQ(1.0f);
+            }
+            glCheckError();
+        }
 
     public:
         multi_render_node()=default;
@@ -68,9 +196,9 @@ namespace nitrogl {
         void init() {
             // configure the vao, vbo, generic vertex attribs, non interleaved
             gva = {{
-                { 0, GL_FLOAT, 2, OFFSET(0), 0, _vbo_pos.id()},
-                { 1, GL_FLOAT, 2, OFFSET(0), 0, _vbo_uvs.id()},
-                { 2, GL_FLOAT, 1, OFFSET(0), 0, _vbo_qs.id()}
+                { 0, GL_FLOAT, 2, OFFSET(0), 0, _vbo_pos.id(), GL_FALSE},
+                { 1, GL_FLOAT, 2, OFFSET(0), 0, _vbo_uvs.id(), GL_FALSE},
+                { 2, GL_FLOAT, 1, OFFSET(0), 0, _vbo_qs.id(), GL_FALSE}
             }};
 
 #ifdef NITROGL_SUPPORTS_VAO
@@ -82,91 +210,98 @@ namespace nitrogl {
 #endif
         }
 
+        /**
+         * select the vertex layout of draws without q, see vertex_layout
+         */
+        void updateVertexLayout(const vertex_layout & layout) { _layout = layout; }
+        const vertex_layout & vertexLayout() const { return _layout; }
+
         void render(const program_type & program, sampler_t & sampler, const data_type & data) const {
             const auto & d = data;
             const bool has_missing_uvs = d.uvs == nullptr;
             const bool has_missing_qs = d.qs == nullptr;
             const bool has_missing_indices = d.indices == nullptr || d.indices_size==0;
 
+            // q is constant when it is missing, so compact layouts may drop it
+            const bool packed = _layout.is_compact() && has_missing_qs;
+            const vertex_layout layout = packed ? fit_layout(d) : vertex_layout();
+            const bool fixed = layout.position==vertex_layout::position_format::fixed16;
+
             program.use();
             // vertex uniforms
-            program.updateModelMatrix(d.mat_model);
+            if(fixed) {
+                // fixed point positions are scaled back to floats by the model matrix
+                const float k = 1.0f/layout.fixed_scale();
+                mat4f mat_model = d.mat_model;
+                mat_model *= mat4f::scale(k, k, 1.0f);
+                program.updateModelMatrix(mat_model);
+            } else program.updateModelMatrix(d.mat_model);
             program.updateViewMatrix(d.mat_view);
             program.updateProjectionMatrix(d.mat_proj);
             program.updateUVsTransformMatrix(d.mat_uvs_sampler);
 
             // fragment uniforms
-            program.update_backdrop_texture(d.backdrop_texture);
             program.update_window_size(d.window_width, d.window_height);
             program.updateOpacity(d.opacity);
-            program.update_has_missing_uvs(has_missing_uvs);
-            program.update_has_missing_qs(has_missing_qs);
-            if(has_missing_uvs)
-                program.updateBBox(d.bbox.left, d.bbox.top, d.bbox.right, d.bbox.bottom);
+            if(has_missing_uvs) {
+                // the bbox is in the units of the positions
+                const float k = fixed ? layout.fixed_scale() : 1.0f;
+                program.updateBBox(d.bbox.left*k, d.bbox.top*k, d.bbox.right*k, d.bbox.bottom*k);
+            }
 
             // sampler uniforms
+            texture_units::current().begin_draw();
             sampler.upload_uniforms(program.id());
+            // the backdrop is bound last, to the scratch unit, that sampler uploads may use
+            program.update_backdrop_texture(d.backdrop_texture);
 
-            static constexpr auto FLOAT_SIZE = GLsizeiptr (sizeof(float));
-            static constexpr auto VEC2_SIZE = GLsizeiptr (sizeof(vec2f));
-
-            // upload pos
-            _vbo_pos.uploadData(d.pos, d.pos_size*VEC2_SIZE,
-                                GL_DYNAMIC_DRAW);
-            // upload uvs
-
-            const vec2f * uvs = d.uvs;
-            GLsizeiptr uvs_count = d.uvs_size;
-            const float * qs = d.qs;
-            GLsizeiptr qs_count = d.qs_size;
-
-            // generate dummy uvs and qs if needed, because we have to supply something
-            // otherwise, open-gl crashes for me if they are completely empty
-            {
-                static const vec2f dummy_uvs[1] = {{0,0}};
-                static const float dummy_qs[1] = { 1.0f };
-                if(has_missing_uvs) {
-                    uvs = dummy_uvs;
-                    uvs_count = 1;
-                }
-                if(has_missing_qs) {
-                    qs = dummy_qs;
-                    qs_count = 1;
-                }
-            }
-            _vbo_uvs.uploadData(uvs, uvs_count*VEC2_SIZE,
-                            GL_DYNAMIC_DRAW);
-            _vbo_qs.uploadData(qs,qs_count*FLOAT_SIZE,
-                                GL_DYNAMIC_DRAW);
+            if(packed) upload_packed(layout, d, !has_missing_uvs);
+            else upload_streams(d);
             // upload indices
-            _ebo.uploadData(d.indices, GLsizeiptr(sizeof(GLuint))*d.indices_size,
-                            GL_DYNAMIC_DRAW);
+            GLenum indices_type = d.indices_type;
+            if(indices_type==GL_UNSIGNED_INT)
+                indices_type = _ebo.uploadNarrowedData(static_cast<const GLuint *>(d.indices),
+                                                       d.indices_size, GL_DYNAMIC_DRAW);
+            else
+                _ebo.uploadData(d.indices, triangles::gl_index_size(indices_type)*d.indices_size,
+                                GL_DYNAMIC_DRAW);
 
 #ifdef NITROGL_SUPPORTS_VAO
             // VAO binds the: glEnableVertex attribs and pointing vertex attribs to VBO and binds the EBO
-            _vao.bind();
+            if(packed) {
+                _vao_packed.bind();
+                // re-point the attributes only when the packed layout changes
+                const int pointed_uvs = has_missing_uvs ? 0 : 1;
+                if(layout!=_packed_pointed_layout || pointed_uvs!=_packed_pointed_uvs) {
+                    configure_packed_gva(layout, !has_missing_uvs);
+                    _ebo.bind();
+                    program_type::point_generic_vertex_attributes(_gva_packed.data,
+                             program_type::shader_vertex_attributes().data, GVA::size());
+                    _packed_pointed_layout = layout; _packed_pointed_uvs = pointed_uvs;
+                }
+            } else _vao.bind();
+            enable_optional_arrays(!has_missing_uvs, !has_missing_qs);
             if(has_missing_indices) // non-indexed drawing, the EBO is bound BUT is not used
                 glDrawArrays(d.triangles_type, 0, GLsizei(d.pos_size));
             else
-                glDrawElements(d.triangles_type, GLsizei (d.indices_size), GL_UNSIGNED_INT, OFFSET(0));
+                glDrawElements(d.triangles_type, GLsizei (d.indices_size), indices_type, OFFSET(0));
 
             glCheckError();
             vao_t::unbind();
 #else
             _ebo.bind();
-            // this crates exccess 2 binds for vbos
-            main_shader_program::point_generic_vertex_attributes(gva.data,
-                    main_shader_program::shader_vertex_attributes().data, gva.size());
+            // software VAO, re-specifies only the attribute state, that changed
+            if(packed) configure_packed_gva(layout, !has_missing_uvs);
+            vertex_attribs_cache::apply(packed ? _gva_packed.data : gva.data, GVA::size(),
+                                        0x1u | (has_missing_uvs ? 0u : 0x2u) | (has_missing_qs ? 0u : 0x4u));
+            if(has_missing_qs) program_type::updateConstantQ(1.0f);
 
             if(has_missing_indices) // non-indexed drawing, the EBO is bound BUT is not used
                 glDrawArrays(d.triangles_type, 0,  GLsizei(d.pos_size));
             else
-                glDrawElements(d.triangles_type, GLsizei (d.indices_size), GL_UNSIGNED_INT, OFFSET(0));
+                glDrawElements(d.triangles_type, GLsizei (d.indices_size), indices_type, OFFSET(0));
 
             glCheckError();
-
-            program.disableLocations(program_type::shader_vertex_attributes().data,
-                                     program_type::shader_vertex_attributes().size());
 #endif
             // un-use shader
             shader_program::unuse();
@@ -13,6 +13,7 @@
 #include "../ogl/shader_program.h"
 #include "../ogl/vao.h"
 #include "../ogl/vbo.h"
+#include "../ogl/vertex_attribs_cache.h"
 #include "../ogl/ebo.h"
 #include "../_internal/main_shader_program.h"
 #include "../samplers/sampler.h"
@@ -65,8 +66,8 @@ namespace nitrogl {
             // configure the vao, vbo, generic vertex attribs [(x,y,u,v) ....], interleaved
             const int STRIDE = 4*sizeof (GLfloat);
             gva = {{
-                { 0, GL_FLOAT, 2, OFFSET(0),                    STRIDE, _vbo_xyuv.id()},
-                { 1, GL_FLOAT, 2, OFFSET(2*sizeof (GLfloat)),   STRIDE, _vbo_xyuv.id()},
+                { 0, GL_FLOAT, 2, OFFSET(0),                    STRIDE, _vbo_xyuv.id(), GL_FALSE},
+                { 1, GL_FLOAT, 2, OFFSET(2*sizeof (GLfloat)),   STRIDE, _vbo_xyuv.id(), GL_FALSE},
             }};
 
 #ifdef NITROGL_SUPPORTS_VAO
@@ -90,14 +91,16 @@ namespace nitrogl {
             program.updateUVsTransformMatrix(d.mat_uvs_sampler);
 
             // fragment uniforms
-            program.update_backdrop_texture(d.backdrop_texture);
             program.update_window_size(d.window_width, d.window_height);
             program.updateOpacity(d.opacity);
-            program.update_has_missing_uvs(false);
-            program.update_has_missing_qs(true);
+            // there is no q array, q is the constant 1
+            program_type::updateConstantQ(1.0f);
 
             // sampler uniforms
+            texture_units::current().begin_draw();
             sampler.upload_uniforms(program.id());
+            // the backdrop is bound last, to the scratch unit, that sampler uploads may use
+            program.update_backdrop_texture(d.backdrop_texture);
 
             static constexpr auto FLOAT_SIZE = GLsizeiptr (sizeof(float));
             static constexpr auto VEC2_SIZE = GLsizeiptr (sizeof(vec2f));
@@ -107,8 +110,8 @@ namespace nitrogl {
                                 GL_DYNAMIC_DRAW);
 
             // upload indices
-            _ebo.uploadData(d.indices, GLsizeiptr(sizeof(GLuint))*d.indices_size,
-                            GL_DYNAMIC_DRAW);
+            const GLenum indices_type = _ebo.uploadNarrowedData(d.indices, d.indices_size,
+                                                                GL_DYNAMIC_DRAW);
 
 #ifdef NITROGL_SUPPORTS_VAO
             // VAO binds the: glEnableVertex attribs and pointing vertex attribs to VBO and binds the EBO
@@ -116,27 +119,22 @@ namespace nitrogl {
             if(has_missing_indices) // non-indexed drawing, the EBO is bound BUT is not used
                 glDrawArrays(d.triangles_type, 0, GLsizei(d.xyuv_size/4));
             else
-                glDrawElements(d.triangles_type, GLsizei (d.indices_size), GL_UNSIGNED_INT, OFFSET(0));
+                glDrawElements(d.triangles_type, GLsizei (d.indices_size), indices_type, OFFSET(0));
 
             glCheckError();
 
             vao_t::unbind();
 #else
             _ebo.bind();
-            // this crates exccess 2 binds for vbos
-            main_shader_program::point_generic_vertex_attributes(gva.data,
-                                                                 main_shader_program::shader_vertex_attributes().data,
-                                                                 gva.size());
+            // software VAO, re-specifies only the attribute state, that changed
+            vertex_attribs_cache::apply(gva.data, GVA::size(), 0x3u);
 
             if(has_missing_indices) // non-indexed drawing, the EBO is bound BUT is not used
                 glDrawArrays(d.triangles_type, 0, GLsizei(d.xyuv_size/4));
             else
-                glDrawElements(d.triangles_type, GLsizei (d.indices_size), GL_UNSIGNED_INT, OFFSET(0));
+                glDrawElements(d.triangles_type, GLsizei (d.indices_size), indices_type, OFFSET(0));
 
             glCheckError();
-
-            program.disableLocations(program_type::shader_vertex_attributes().data,
-                                     program_type::shader_vertex_attributes().size());
 #endif
             // un-use shader
             shader_program::unuse();
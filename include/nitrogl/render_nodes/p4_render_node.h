@@ -11,6 +11,7 @@
 #pragma once
 
 #include "../ogl/shader_program.h"
+#include "../ogl/vertex_attribs_cache.h"
 #include "../_internal/main_shader_program.h"
 #include "../samplers/sampler.h"
 
@@ -58,15 +59,15 @@ namespace nitrogl {
 
             gva = {{
                 { 0, GL_FLOAT, 2, OFFSET(0),
-                  STRIDE, _vbo_pos_uvs_qs.id()},
+                  STRIDE, _vbo_pos_uvs_qs.id(), GL_FALSE},
                 { 1, GL_FLOAT, 2, OFFSET(2*sizeof (GLfloat)),
-                  STRIDE, _vbo_pos_uvs_qs.id()},
+                  STRIDE, _vbo_pos_uvs_qs.id(), GL_FALSE},
                 { 2, GL_FLOAT, 1, OFFSET(4*sizeof (GLfloat)),
-                  STRIDE, _vbo_pos_uvs_qs.id()}
+                  STRIDE, _vbo_pos_uvs_qs.id(), GL_FALSE}
             }};
 
             // elements buffer
-            GLuint e[6] = { 0, 1, 2, 2, 3, 0 };
+            GLushort e[6] = { 0, 1, 2, 2, 3, 0 };
             _vao.bind();
             _ebo.uploadData(e, sizeof(e), GL_STATIC_DRAW);
 
@@ -85,16 +86,16 @@ namespace nitrogl {
             program.updateViewMatrix(d.mat_view);
             program.updateProjectionMatrix(d.mat_proj);
             program.updateUVsTransformMatrix(d.mat_uvs_sampler);
-            program.update_has_missing_uvs(false);
-            program.update_has_missing_qs(false);
 
             // fragment uniforms
-            program.update_backdrop_texture(d.backdrop_texture);
             program.update_window_size(d.window_width, d.window_height);
             program.updateOpacity(d.opacity);
 
             // sampler uniforms
+            texture_units::current().begin_draw();
             sampler.upload_uniforms(program.id());
+            // the backdrop is bound last, to the scratch unit, that sampler uploads may use
+            program.update_backdrop_texture(d.backdrop_texture);
 
             static constexpr auto FLOAT_SIZE = GLsizeiptr (sizeof(float));
             // upload data
@@ -105,18 +106,15 @@ namespace nitrogl {
 #ifdef NITROGL_SUPPORTS_VAO
             // VAO binds the: glEnableVertex attribs and pointing vertex attribs to VBO and binds the EBO
             _vao.bind();
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, OFFSET(0));
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, OFFSET(0));
             glCheckError();
             vao_t::unbind();
 #else
             _ebo.bind();
-            // this crates exccess 2 binds for vbos
-            program_type::point_generic_vertex_attributes(gva.data,
-                    program_type::shader_vertex_attributes().data, gva.size());
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, OFFSET(0));
+            // software VAO, re-specifies only the attribute state, that changed
+            vertex_attribs_cache::apply(gva.data, GVA::size(), 0x7u);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, OFFSET(0));
             glCheckError();
-            program.disableLocations(program_type::shader_vertex_attributes().data,
-                                     program_type::shader_vertex_attributes().size());
 #endif
             // unuse shader
             shader_program::unuse();
@@ -0,0 +1,102 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "../_internal/ogl_info.h"
+
+namespace nitrogl {
+
+    /**
+     * Vertex format of `multi_render_node`. The default layout is three separate float
+     * streams (vec2 pos, vec2 uv, float q), 20 bytes per vertex. Compact layouts interleave
+     * the position and the uv in a single buffer and drop q, which is constant (1) unless
+     * a draw supplies it (draws with q always use the float streams):
+     *
+     * - positions as floats, or as 16 bit fixed point `GL_SHORT` with `fixed_precision`
+     *   fractional bits, same as micro-tess `Q<fixed_precision>`. The scale back to floats
+     *   is folded into the model matrix uniform, so the vertex shader is unchanged.
+     * - uvs as floats, `GL_HALF_FLOAT` or `GL_UNSIGNED_SHORT` normalized (uvs in [0..1]).
+     *   without half float vertices (gl-es-2), `half16` is kept as floats
+     *
+     * A draw that does not fit a compact format (positions beyond the fixed point range,
+     * uvs outside [0..1]) falls back to floats for that component only.
+     * Example, 4 fractional bits allow positions in [-2048..2048) at 1/16 pixel:
+     *      canvas.updateVertexLayout({ vertex_layout::position_format::fixed16,
+     *                                  vertex_layout::uv_format::unorm16, 4 });
+     */
+    struct vertex_layout {
+        enum class position_format { float32, fixed16 };
+        enum class uv_format { float32, half16, unorm16 };
+
+        position_format position;
+        uv_format uv;
+        unsigned char fixed_precision;
+
+        constexpr vertex_layout(position_format position=position_format::float32,
+                                uv_format uv=uv_format::float32,
+                                unsigned char fixed_precision=4) :
+                        position(position),
+#ifdef NITROGL_SUPPORTS_HALF_FLOAT_VERTICES
+                        uv(uv),
+#else
+                        uv(uv==uv_format::half16 ? uv_format::float32 : uv),
+#endif
+                        fixed_precision(fixed_precision>14 ? 14 : fixed_precision) {}
+
+        /**
+         * the default, separate float streams with q
+         */
+        bool is_compact() const
+        { return position!=position_format::float32 || uv!=uv_format::float32; }
+        bool operator==(const vertex_layout & o) const
+        { return position==o.position && uv==o.uv && fixed_precision==o.fixed_precision; }
+        bool operator!=(const vertex_layout & o) const { return !(*this==o); }
+
+        GLsizei position_bytes() const { return position==position_format::fixed16 ? 4 : 8; }
+        GLsizei uv_bytes() const { return uv==uv_format::float32 ? 8 : 4; }
+        GLenum position_gl_type() const { return position==position_format::fixed16 ? GL_SHORT : GL_FLOAT; }
+        GLenum uv_gl_type() const {
+#ifdef NITROGL_SUPPORTS_HALF_FLOAT_VERTICES
+            if(uv==uv_format::half16) return GL_HALF_FLOAT;
+#endif
+            return uv==uv_format::unorm16 ? GL_UNSIGNED_SHORT : GL_FLOAT;
+        }
+        GLboolean uv_normalized() const { return uv==uv_format::unorm16 ? GL_TRUE : GL_FALSE; }
+        /**
+         * the fixed point scale, positions are stored as round(value * scale)
+         */
+        float fixed_scale() const { return float(1u<<fixed_precision); }
+
+        /**
+         * IEEE 754 binary16 conversion, rounds to nearest, overflow becomes infinity
+         */
+        static GLushort float_to_half(float value) {
+            union { float f; GLuint u; } v; v.f=value;
+            const GLuint sign = (v.u>>16) & 0x8000u;
+            int exponent = int((v.u>>23) & 0xFFu) - 127 + 15;
+            GLuint mantissa = v.u & 0x7FFFFFu;
+            if(exponent>=31) return GLushort(sign | 0x7C00u);
+            if(exponent<=0) { // sub-normal
+                if(exponent<-10) return GLushort(sign);
+                mantissa |= 0x800000u;
+                const GLuint shift = GLuint(14-exponent);
+                return GLushort(sign | ((mantissa + (1u<<(shift-1)))>>shift));
+            }
+            mantissa += 0x1000u;
+            if(mantissa & 0x800000u) {
+                mantissa = 0; ++exponent;
+                if(exponent>=31) return GLushort(sign | 0x7C00u);
+            }
+            return GLushort(sign | (GLuint(exponent)<<10) | (mantissa>>13));
+        }
+    };
+
+}
@@ -20,6 +20,11 @@ namespace nitrogl {
      * A 2D Piece-wise Function sampler:
      * 1. Composed out of finite segments
      * 2. up to 100 points or 99 segments
+     * 3. segments are indexed into uniform buckets along the x axis, so each
+     *    fragment only tests the segments near its column instead of all of them.
+     *    Inside the stroke and anti-alias bands the result is exact, farther away
+     *    only the side of the function matters, which works well for functions
+     *    (sparklines, waveforms), that are monotone in x.
      *
      */
     template<int MAX_POINTS=(6 + 2*100)>
@@ -29,8 +34,9 @@ namespace nitrogl {
         const char * uniforms() const override {
             return R"(
 {
-    // size, offset, window_size, stroke-width, aa_fill, aa_stroke, x,y,x,y,x,y......
-    float inputs[6 + 2*100];
+    // size, offset, window_size, stroke-width, aa_fill, aa_stroke, buckets, buckets offset,
+    // x,y,x,y,x,y......, first,last,first,last......
+    float inputs[8 + 2*100 + 2*32];
 }
 )";
         }
@@ -50,8 +56,21 @@ namespace nitrogl {
     // aa fill and stroke, mul by 2 for more beautiful
     float aa_fill = data.inputs[4]*2.0;
     float aa_stroke = data.inputs[5]*2.0;
+    int buckets = int(data.inputs[6]);
+    int buckets_offset = int(data.inputs[7]);
     vec2 p = uv.xy;
 
+    /////////////
+    // bucket of segments [first, last) around the column of p
+    /////////////
+    int first = 0;
+    int last = count-1;
+    if(buckets>0) {
+        int b = int(clamp(p.x, 0.0, 0.99999)*float(buckets));
+        first = int(data.inputs[buckets_offset + 2*b]);
+        last = int(data.inputs[buckets_offset + 2*b + 1]);
+    }
+
     /////////////
     // SDF function
     /////////////
@@ -60,7 +79,7 @@ namespace nitrogl {
     // BUT SDFs union/intersection ops with min/max dont work well for me.
     float d_squared = 1000000.0;
     float sign_ = 0.0;
-    for(int ix=0, jx=offset; ix<count-1; ++ix, jx+=2) {
+    for(int ix=first, jx=offset+first*window_size; ix<last; ++ix, jx+=window_size) {
         vec2 a = vec2(data.inputs[jx], data.inputs[jx+1]);
         vec2 b = vec2(data.inputs[jx+2], data.inputs[jx+3]);
         vec2 pa = p-a, ba = b-a;
@@ -101,34 +120,83 @@ namespace nitrogl {
             return  2;
         }
         constexpr int offset() const {
-            // [0]=index, [1]=window_size, [2]=offset
-            return  6;
+            // [0]=index, [1]=window_size, [2]=offset, [3..5]=stroke and aa, [6..7]=buckets
+            return  8;
+        }
+        static constexpr int max_buckets() {
+            return  32;
         }
-        constexpr int overall_size() const {
+        int buckets_offset() const {
             return  offset() + size*window_size();
         }
+        int overall_size() const {
+            return  buckets_offset() + 2*buckets_count();
+        }
+        int buckets_count() const {
+            // below a few segments, a plain loop is as fast
+            return  size>8 ? max_buckets() : 0;
+        }
 
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
             // minus the where float
-            static float inputs[MAX_POINTS];
+            static float inputs[MAX_POINTS + 2 + 2*max_buckets()];
             inputs[0] = float(size);
             inputs[1] = float(window_size()); // window size
             inputs[2] = float(offset()); // window size
             inputs[3] = stroke_width; // window size
             inputs[4] = aa_fill; // window size
             inputs[5] = aa_stroke; // window size
+            inputs[6] = float(buckets_count());
+            inputs[7] = float(buckets_offset());
             for (int ix = 0; ix < size; ++ix) {
                 int jx = offset() + ix * window_size();
                 inputs[jx + 0] = points[ix].x;
                 inputs[jx + 1] = points[ix].y;
             }
+            update_buckets(inputs + buckets_offset());
             GLint loc_inputs = get_uniform_location(program, "inputs");
             glUniform1fv(loc_inputs, overall_size(), inputs);
         }
 
+    private:
+        /**
+         * Bucket b covers the column [b/B, (b+1)/B] in x, and records the range of
+         * segments [first, last), that reach the column expanded by the bands of the
+         * stroke and anti-aliasing. Every segment, that is closer to a fragment than the
+         * bands, is therefore in its bucket.
+         */
+        void update_buckets(float * buckets) const {
+            const int B = buckets_count();
+            const int segments = size-1;
+            const float sw = stroke_width/2.0f + aa_stroke*2.0f;
+            const float fw = aa_fill*2.0f;
+            const float margin = sw>fw ? sw : fw;
+            for (int b = 0; b < B; ++b) {
+                const float lo = float(b)/float(B) - margin;
+                const float hi = float(b+1)/float(B) + margin;
+                int first = segments, last = 0;
+                int closest = 0; float closest_dist = 1000000.0f;
+                for (int ix = 0; ix < segments; ++ix) {
+                    const float x0 = points[ix].x, x1 = points[ix+1].x;
+                    const float x_min = x0<x1 ? x0 : x1, x_max = x0<x1 ? x1 : x0;
+                    if(x_max>=lo && x_min<=hi) {
+                        if(ix<first) first=ix;
+                        last=ix+1;
+                    }
+                    // fallback for empty buckets: the segment closest in x
+                    const float dist = x_max<lo ? lo-x_max : (x_min>hi ? x_min-hi : 0.0f);
+                    if(dist<closest_dist) { closest_dist=dist; closest=ix; }
+                }
+                if(last==0) { first=closest; last=closest+1; }
+                buckets[(b<<1) + 0] = float(first);
+                buckets[(b<<1) + 1] = float(last);
+            }
+        }
+
+    public:
         vec2f * points;
         int size;
         float stroke_width;
@@ -136,6 +204,7 @@ namespace nitrogl {
 
         void update_points(vec2f * $points, int $size) {
             points=$points; size=$size;
+            invalidate_uniforms();
         }
 
         /**
@@ -0,0 +1,128 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/canvas.h>
+#include <nitrogl/ogl/render_target_pool.h>
+#include <nitrogl/samplers/texture_sampler.h>
+#include <nitrogl/samplers/filters/blur_pass_sampler.h>
+#include <nitrogl/samplers/filters/offscreen_canvas.h>
+
+namespace nitrogl {
+
+    /**
+     * A gaussian blur filter stage for any sampler tree:
+     * 1. The sampler is rendered into a pooled offscreen texture at a reduced resolution.
+     *    The radius chooses the downsample factor, so every pass has at most
+     *    `blur_pass_sampler::max_radius` taps per side, no matter how large the radius is.
+     * 2. Two separable gaussian passes (horizontal, vertical) ping-pong between two pooled
+     *    textures.
+     * 3. The result is exposed as a `texture_sampler`, that is up-scaled with linear filtering
+     *    when drawn.
+     *
+     * Notes:
+     * - The blur spreads beyond the bounds of the sampler, so the result has a transparent
+     *   `margin()` around it. Draw it over the rect grown by the margin on each side.
+     * - The result texture is valid until the next `apply` or `release`.
+     *
+     * Example, a drop shadow:
+     *      auto shadow = filter.apply(tint, 100, 100, 24.0f);
+     *      const float m = filter.margin();
+     *      canvas.drawRect(shadow, left-m+dx, top-m+dy, left+100+m+dx, top+100+m+dy);
+     *
+     * @tparam Allocator allocator for the internal book-keeping
+     */
+    template<class Allocator=nitrogl::std_rebind_allocator<>>
+    class blur_filter {
+        render_target_pool<Allocator> _pool;
+        offscreen_canvas<Allocator> _canvas;
+        gl_texture _result;
+        float _margin;
+
+        void draw_copy(const gl_texture & target, const sampler_t & sampler,
+                       float left, float top, float right, float bottom, bool clear) {
+            auto & c = _canvas.target(target);
+            if(clear) c.clear(0.0f, 0.0f, 0.0f, 0.0f);
+            c.drawRect(sampler, left, top, right, bottom);
+        }
+
+    public:
+        explicit blur_filter(unsigned max_idle_targets=4, const Allocator & allocator=Allocator()) :
+                _pool(max_idle_targets, allocator), _canvas(allocator),
+                _result(gl_texture::un_generated_dummy()),
+                _margin(0.0f) {}
+        blur_filter(const blur_filter &)=delete;
+        blur_filter & operator=(const blur_filter &)=delete;
+        ~blur_filter() { _canvas.release(); _pool.clear(); }
+
+        /**
+         * @return the downsample factor for a blur radius (1, 2, 4, 8, ...)
+         */
+        static unsigned downsample_factor(float radius) {
+            unsigned factor = 1;
+            while(radius/float(factor) > float(blur_pass_sampler::max_radius)) factor<<=1;
+            return factor;
+        }
+
+        /**
+         * Render a blurred sampler
+         * @param sampler the sampler to blur
+         * @param width/height the size, the sampler is drawn at
+         * @param radius blur radius in pixels (about 3 standard deviations)
+         * @return a sampler of the blurred result, it is (width + 2*margin()) x (height + 2*margin())
+         */
+        texture_sampler apply(const sampler_t & sampler, float width, float height, float radius) {
+            release();
+            radius = radius<0.0f ? 0.0f : radius;
+            const unsigned factor = downsample_factor(radius);
+            const float f = float(factor);
+            // whole texels of margin, so the sampler lands on the texel grid
+            const float margin_texels = float(int(radius/f + 1.0f));
+            _margin = margin_texels*f;
+            const auto w = GLsizei(int((width + 2.0f*_margin)/f + 0.5f));
+            const auto h = GLsizei(int((height + 2.0f*_margin)/f + 0.5f));
+            const auto ping = _pool.acquire(w<1 ? 1 : w, h<1 ? 1 : h);
+            const auto pong = _pool.acquire(ping.width(), ping.height());
+            const float W = float(ping.width()), H = float(ping.height());
+            // 1. render the sampler downsampled, surrounded by a transparent margin
+            draw_copy(ping, sampler, margin_texels, margin_texels,
+                      W-margin_texels, H-margin_texels, true);
+            // 2. separable passes
+            const int r = int(radius/f + 0.5f);
+            const float sigma = radius/f/3.0f;
+            draw_copy(pong, blur_pass_sampler(ping, r, sigma, true), 0, 0, W, H, false);
+            draw_copy(ping, blur_pass_sampler(pong, r, sigma, false), 0, 0, W, H, false);
+            _pool.release(pong);
+            _result = ping;
+            return texture_sampler(_result);
+        }
+
+        /**
+         * the transparent margin around the result, in pixels
+         */
+        float margin() const { return _margin; }
+        /**
+         * @return non-owning copy of the result texture of the last `apply`
+         */
+        const gl_texture & result() const { return _result; }
+
+        /**
+         * return the result texture to the pool
+         */
+        void release() {
+            if(_result.wasGenerated()) _pool.release(_result);
+            _result = gl_texture::un_generated_dummy();
+        }
+
+        render_target_pool<Allocator> & pool() { return _pool; }
+    };
+
+}
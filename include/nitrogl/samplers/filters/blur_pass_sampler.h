@@ -0,0 +1,88 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/samplers/sampler.h>
+#include <nitrogl/ogl/gl_texture.h>
+
+namespace nitrogl {
+
+    /**
+     * One pass of a separable gaussian blur of a pre-multiplied alpha texture, along a
+     * single direction. Two passes (horizontal, then vertical) make a full gaussian blur
+     * with 2x(2r+1) taps instead of (2r+1)^2 taps. Used by `blur_filter`.
+     * - blurring happens in pre-multiplied space, so transparent texels do not bleed color
+     * - the radius is in texels and at most `max_radius`, larger blurs are done on
+     *   downsampled textures, see `blur_filter`
+     */
+    struct blur_pass_sampler : public sampler_t {
+        static constexpr int max_radius = 8;
+
+        const char * name() const override { return "blur_pass_sampler"; }
+        const char * uniforms() const override {
+            return R"(
+{
+    sampler2D texture;
+    vec2 direction;
+    float sigma;
+    int radius;
+}
+)";
+        }
+
+        const char * main() const override {
+            return R"(
+(in vec3 uv) {
+    float s2 = 2.0*data.sigma*data.sigma;
+    vec4 sum = vec4(0.0);
+    float total = 0.0;
+    for (int ix=-8; ix<=8; ++ix) {
+        if(ix<-data.radius || ix>data.radius) continue;
+        float w = exp(-float(ix*ix)/s2);
+        sum += w*TEXTURE_2D(data.texture, uv.xy + float(ix)*data.direction);
+        total += w;
+    }
+    sum /= total;
+    // samplers output un-multiplied alpha
+    if(sum.a>0.0) sum.rgb/=sum.a;
+    return sum;
+}
+)";
+        }
+
+        void on_cache_uniforms_locations(GLuint program) override {
+        }
+
+        void on_upload_uniforms_request(GLuint program) override {
+            glUniform1i(get_uniform_location(program, "texture"), texture.use());
+            glUniform2f(get_uniform_location(program, "direction"),
+                        horizontal ? 1.0f/float(texture.width()) : 0.0f,
+                        horizontal ? 0.0f : 1.0f/float(texture.height()));
+            glUniform1f(get_uniform_location(program, "sigma"), sigma>0.0f ? sigma : 1.0f);
+            glUniform1i(get_uniform_location(program, "radius"),
+                        radius<0 ? 0 : (radius>max_radius ? max_radius : radius));
+        }
+
+        gl_texture texture;
+        float sigma;
+        int radius;
+        bool horizontal;
+
+        /**
+         * @param texture pre-multiplied alpha texture (a non-owning copy is kept)
+         * @param radius radius in texels [0..max_radius]
+         * @param sigma standard deviation in texels
+         * @param horizontal blur direction
+         */
+        blur_pass_sampler(const gl_texture & texture, int radius, float sigma, bool horizontal) :
+                texture(texture), sigma(sigma), radius(radius), horizontal(horizontal), sampler_t() {}
+    };
+}
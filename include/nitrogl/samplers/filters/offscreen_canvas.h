@@ -0,0 +1,63 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/canvas.h>
+
+namespace nitrogl {
+
+    /**
+     * A canvas for filters, that render into many textures. It is created with the first
+     * target and re-targeted afterwards (see `canvas::updateRenderTarget`), so the fbo, the
+     * backdrop and the render nodes are not rebuilt for every pass.
+     * The canvas composites with Copy, it replaces the pixels of the target.
+     *
+     * @tparam Allocator allocator of the canvas
+     */
+    template<class Allocator=nitrogl::std_rebind_allocator<>>
+    class offscreen_canvas {
+        using canvas_allocator_t = typename Allocator::template rebind<canvas>::other;
+        canvas_allocator_t _allocator;
+        canvas * _canvas;
+
+    public:
+        explicit offscreen_canvas(const Allocator & allocator=Allocator()) :
+                _allocator(allocator), _canvas(nullptr) {}
+        offscreen_canvas(const offscreen_canvas &)=delete;
+        offscreen_canvas & operator=(const offscreen_canvas &)=delete;
+        ~offscreen_canvas() { release(); }
+
+        /**
+         * @return the canvas, that renders into the target
+         */
+        canvas & target(const gl_texture & texture) {
+            if(_canvas) {
+                _canvas->updateRenderTarget(texture);
+                return *_canvas;
+            }
+            _canvas = _allocator.allocate(1);
+            _allocator.construct(_canvas, texture);
+            _canvas->update_composition(blend_modes::Normal(), porter_duff::Copy());
+            return *_canvas;
+        }
+
+        /**
+         * destroy the canvas, the next `target` creates a new one
+         */
+        void release() {
+            if(!_canvas) return;
+            _canvas->~canvas();
+            _allocator.deallocate(_canvas);
+            _canvas = nullptr;
+        }
+    };
+
+}
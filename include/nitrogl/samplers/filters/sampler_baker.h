@@ -0,0 +1,144 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/canvas.h>
+#include <nitrogl/samplers/texture_sampler.h>
+#include <nitrogl/samplers/filters/offscreen_canvas.h>
+
+namespace nitrogl {
+
+    /**
+     * Bakes expensive sampler sub-trees, that are static in uv space (function charts,
+     * multi-stop gradients under masks etc..), into textures. The returned `texture_sampler`
+     * replaces the sub-tree in it's parent tree, so every fragment does a single fetch.
+     *
+     * - Bakes are cached per (sampler, width, height). A bake is redone only when the
+     *   `hash_code()` (shader structure) or the `uniforms_version()` of the sub-tree change.
+     * - At most `max_entries` textures are kept, least recently baked/used are deleted.
+     * - Baked textures are pre-multiplied alpha with linear filtering, bake at the size,
+     *   the sampler is drawn at, to keep it sharp.
+     *
+     * Example:
+     *      auto baked = baker.bake(chart, 256, 128);
+     *      mask_sampler masked{&baked, &mask};
+     *
+     * @tparam Allocator allocator for the internal book-keeping
+     */
+    template<class Allocator=nitrogl::std_rebind_allocator<>>
+    class sampler_baker {
+        struct entry_t {
+            const sampler_t * sampler;
+            nitrogl::uintptr_type hash, version;
+            gl_texture texture;
+            unsigned long stamp;
+        };
+        using entries_allocator_t = typename Allocator::template rebind<entry_t>::other;
+
+        dynamic_array<entry_t, entries_allocator_t> _entries;
+        offscreen_canvas<Allocator> _canvas;
+        unsigned _max_entries;
+        unsigned long _clock;
+        unsigned long _bakes;
+
+        int index_of(const sampler_t * sampler, GLsizei width, GLsizei height) const {
+            for (unsigned ix = 0; ix < _entries.size(); ++ix) {
+                const auto & e = _entries[ix];
+                if(e.sampler==sampler && e.texture.width()==width && e.texture.height()==height)
+                    return int(ix);
+            }
+            return -1;
+        }
+
+        void remove_at(unsigned index) {
+            _entries[index].texture.del();
+            const unsigned last = _entries.size()-1;
+            if(index!=last) _entries[index] = nitrogl::traits::move(_entries[last]);
+            _entries.pop_back();
+        }
+
+        void render(const gl_texture & target, sampler_t & sampler) {
+            _canvas.target(target).drawRect(sampler, 0.0f, 0.0f,
+                                            float(target.width()), float(target.height()));
+        }
+
+    public:
+        /**
+         * @param max_entries how many baked textures to keep
+         */
+        explicit sampler_baker(unsigned max_entries=8, const Allocator & allocator=Allocator()) :
+                _entries(entries_allocator_t(allocator)), _canvas(allocator), _max_entries(max_entries ? max_entries : 1),
+                _clock(0), _bakes(0) {}
+        sampler_baker(const sampler_baker &)=delete;
+        sampler_baker & operator=(const sampler_baker &)=delete;
+        ~sampler_baker() { _canvas.release(); clear(); }
+
+        /**
+         * Render a sampler sub-tree into a cached texture, if it changed since the last bake
+         * @param sampler the sub-tree root, it is identified by it's address
+         * @param width/height size of the texture
+         * @return a sampler of the baked texture
+         */
+        texture_sampler bake(sampler_t & sampler, GLsizei width, GLsizei height) {
+            width = width<1 ? 1 : width; height = height<1 ? 1 : height;
+            const auto hash = sampler.hash_code();
+            const auto version = sampler.uniforms_version();
+            int index = index_of(&sampler, width, height);
+            if(index<0) {
+                if(_entries.size()>=_max_entries) {
+                    unsigned lru = 0;
+                    for (unsigned ix = 1; ix < _entries.size(); ++ix)
+                        if(_entries[ix].stamp<_entries[lru].stamp) lru = ix;
+                    remove_at(lru);
+                }
+                _entries.push_back({ &sampler, hash, version,
+                                     gl_texture::empty(width, height, GL_RGBA, true, 1,
+                                                       GL_LINEAR, GL_LINEAR,
+                                                       GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE),
+                                     0 });
+                index = int(_entries.size()-1);
+                render(_entries[index].texture, sampler); ++_bakes;
+            } else if(_entries[index].hash!=hash || _entries[index].version!=version) {
+                render(_entries[index].texture, sampler); ++_bakes;
+                _entries[index].hash = hash; _entries[index].version = version;
+            }
+            _entries[index].stamp = ++_clock;
+            return texture_sampler(_entries[index].texture);
+        }
+
+        /**
+         * forget all the bakes of a sampler, call it before the sampler is destroyed, if
+         * another sampler might be allocated at the same address
+         */
+        void invalidate(const sampler_t & sampler) {
+            for (unsigned ix = 0; ix < _entries.size();) {
+                if(_entries[ix].sampler==&sampler) remove_at(ix);
+                else ++ix;
+            }
+        }
+
+        /**
+         * delete all the baked textures
+         */
+        void clear() {
+            for (unsigned ix = 0; ix < _entries.size(); ++ix)
+                _entries[ix].texture.del();
+            _entries.clear();
+        }
+
+        unsigned size() const { return _entries.size(); }
+        /**
+         * how many times a sampler was rendered
+         */
+        unsigned long bakes() const { return _bakes; }
+    };
+
+}
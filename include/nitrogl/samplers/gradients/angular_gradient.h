@@ -14,6 +14,7 @@
 #include <nitrogl/color.h>
 #include <nitrogl/math/vertex2.h>
 #include <nitrogl/traits.h>
+#include <nitrogl/samplers/gradients/gradient_lut.h>
 #include <nitrogl/math.h>
 
 namespace nitrogl {
@@ -22,20 +23,56 @@ namespace nitrogl {
      * Angular Gradient sampler.
      *
      * Notes:
-     * - Can hold up to 10 colors
+     * - Can hold up to N colors, the shader arrays are sized to N and the stops
+     *   loop has a fixed length of N
+     * - LUT mode bakes the stops into a 1D texture, see `gradient_lut`
+     * - Angles between the last stop and the first one, wrapping around the interval,
+     *   interpolate from the last color back to the first, in both modes
      */
-    struct angular_gradient : public sampler_t {
+    template<unsigned N>
+    struct basic_angular_gradient : public sampler_t {
         const char * name() const override { return "line_gradient"; }
+        nitrogl::uintptr_type hash_code() const override {
+            // N sizes the shader arrays and loop, so it is part of the shader identity
+            microc::iterative_murmur<nitrogl::uintptr_type> murmur;
+            murmur.begin_cast(main());
+            murmur.next(N);
+            return murmur.end();
+        }
+
         const char * uniforms() const override {
-            return R"(
+            if(_lut_mode)
+                return R"(
 {
-    float inputs[15*6+5];
+    // from radian, 1/(to-from) radians, texel scale, texel bias
+    float inputs[4];
+    sampler2D lut;
 }
 )";
+            // specialized once per N, so the pointer is stable and unique per N
+            static const char uniforms_template[] = R"(
+{
+    float inputs[$N*6+5];
+}
+)";
+            static char source[sizeof(uniforms_template) + 64];
+            static const char * const specialized =
+                    nitrogl::specialize_int_into(source, sizeof(source), uniforms_template, "$N", N);
+            return specialized;
         }
 
         const char * main() const override {
-            return R"(
+            if(_lut_mode)
+                return R"(
+(in vec3 uv) {
+    vec2 p = uv.xy - 0.5f;
+    float angle = -atan(p.t, -p.s) + 3.14159;
+    float t = clamp((angle - data.inputs[0])*data.inputs[1], 0.0, 1.0);
+    return TEXTURE_2D(data.lut, vec2(t*data.inputs[2] + data.inputs[3], 0.5));
+}
+)";
+            // specialized once per N, so the pointer is stable and unique per N
+            static const char main_template[] = R"(
 (in vec3 uv) {
     //////////////
     // main input
@@ -44,8 +81,8 @@ namespace nitrogl {
     int count = int(data.inputs[0]);
     int window_size = int(data.inputs[1]);
     int offset = int(data.inputs[2]);
-    int from_rad = int(data.inputs[3]);
-    int to_rad = int(data.inputs[4]);
+    float from_rad = data.inputs[3];
+    float to_rad = data.inputs[4];
     vec2 p = uv.xy - 0.5f;
 
 #define IDX(a) (offset + (a) * (window_size))
@@ -53,21 +90,24 @@ namespace nitrogl {
 
     //
     int pos = 0;
-    float angle = -atan(p.t, -p.s) + PI;
-    float distance_to_closest_stop = 0.0;
-    for (pos=0; pos<count; ++pos) {
+    float angle = clamp(-atan(p.t, -p.s) + PI, from_rad, to_rad);
+    // before the first stop, the angle is on the wrap segment, that starts at the last stop
+    float distance_to_closest_stop = angle - from_rad + to_rad - data.inputs[IDX(count>0 ? count-1 : 0)];
+    for (pos=0; pos<$N; ++pos) {
+        if(pos>=count) break;
         int idx = IDX(pos);
         // distance to this angular stop
-        float d = clamp(angle, from_rad, to_rad) - data.inputs[idx+0];
-        if(d<0) break;
+        float d = angle - data.inputs[idx+0];
+        if(d<0.0) break;
         distance_to_closest_stop=d;
     }
 
     pos=(pos-1 + count) % count;
     int l_idx = IDX(pos);
     int r_idx = IDX((pos+1)% count);
+    // the segment of the first stop is the wrap segment
     float segment_length= data.inputs[r_idx+1];
-    float factor= distance_to_closest_stop/segment_length;
+    float factor= segment_length>0.0 ? distance_to_closest_stop/segment_length : 0.0;
     float edge0 = 1.0f;//1.0f-0.05;
     float edge1 = 1.0f;
 //    factor = 0.0;//clamp((factor - edge0) / (edge1 - edge0), 0.0, 1.0);
@@ -83,6 +123,10 @@ namespace nitrogl {
     return final;
 }
 )";
+            static char source[sizeof(main_template) + 64];
+            static const char * const specialized =
+                    nitrogl::specialize_int_into(source, sizeof(source), main_template, "$N", N);
+            return specialized;
         }
 
     private:
@@ -98,9 +142,10 @@ namespace nitrogl {
         }
     public:
 
-        static angular_gradient from_rainbow(float from_deg_radian=0.0f,
+        static basic_angular_gradient from_rainbow(float from_deg_radian=0.0f,
                                              float to_deg_radian=2.0f*nitrogl::math::pi<float>()) {
-            angular_gradient gradient { from_deg_radian, to_deg_radian };
+            static_assert(N>=13, "rainbow requires at least 13 stops");
+            basic_angular_gradient gradient { from_deg_radian, to_deg_radian };
             float h = 1.0f/13;
             gradient.addStop(h*0, {0.5,1.0,0, 1});
             gradient.addStop(h*1, {1.0,1.0,0, 1});
@@ -122,8 +167,16 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
+            if(_lut_mode) {
+                const float len = _interval.y-_interval.x;
+                float inputs[4] = { _interval.x, len!=0.0f ? 1.0f/len : 0.0f,
+                                    gradient_lut::wrap_texel_scale(), gradient_lut::wrap_texel_bias() };
+                glUniform1fv(get_uniform_location(program, "inputs"), 4, inputs);
+                gradient_lut::use(_stops, _index, get_uniform_location(program, "lut"), true);
+                return;
+            }
             // minus the where float
-            float inputs[5 + 6*15];
+            float inputs[5 + 6*N];
             inputs[0] = float(_index);
             inputs[1] = float(window_size()); // window size
             inputs[2] = float(offset()); // window size
@@ -133,7 +186,7 @@ namespace nitrogl {
                 const auto & stop = _stops[ix];
                 int jx = offset() + ix * window_size();
                 inputs[jx + 0] = stop.angle;
-                inputs[jx + 1] = stop.segment_length;
+                inputs[jx + 1] = ix ? stop.segment_length : wrap_segment_length();
                 inputs[jx + 2] = stop.color.r;
                 inputs[jx + 3] = stop.color.g;
                 inputs[jx + 4] = stop.color.b;
@@ -158,7 +211,7 @@ namespace nitrogl {
         }
 
         void updateStop(int index, float where, color_t color) {
-            if(index>_index) {
+            if(index>_index || index>=int(N)) {
 #ifndef NITROGL_DISABLE_THROW
                 struct out_of_range{};
                 throw out_of_range{};
@@ -166,6 +219,7 @@ namespace nitrogl {
                 return;
             }
 
+            invalidate_uniforms();
             auto & stop = _stops[index];
 
             stop.where = where;
@@ -182,19 +236,35 @@ namespace nitrogl {
             ++_index;
         }
         int stops() const { return _index; }
+        /**
+         * the angle from the last stop, around the interval ends, to the first stop
+         */
+        float wrap_segment_length() const {
+            if(_index==0) return 0.0f;
+            return (_interval.y - _stops[_index-1].angle) + (_stops[0].angle - _interval.x);
+        }
+
+        void reset() { _index=0; invalidate_uniforms(); }
 
-        void reset() { _index=0; }
+        /**
+         * LUT mode bakes the stops ramp into a cached 1D texture
+         */
+        void setLUTMode(bool on) { _lut_mode=on; invalidate_uniforms(); }
+        bool isLUTMode() const { return _lut_mode; }
 
     private:
         vec2f _interval;
         int _index = 0;
-        stop_t _stops[15] {};
+        bool _lut_mode = false;
+        stop_t _stops[N] {};
 
     public:
-        explicit angular_gradient(float from_deg_radian=0.0f, float to_deg_radian=2.0f*nitrogl::math::pi<float>()) :
+        explicit basic_angular_gradient(float from_deg_radian=0.0f, float to_deg_radian=2.0f*nitrogl::math::pi<float>()) :
             _interval(from_deg_radian, to_deg_radian) {
             setNewInterval(_interval);
         };
 
     };
+
+    using angular_gradient = basic_angular_gradient<15>;
 }
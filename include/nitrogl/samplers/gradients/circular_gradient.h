@@ -14,6 +14,7 @@
 #include <nitrogl/color.h>
 #include <nitrogl/math/vertex2.h>
 #include <nitrogl/traits.h>
+#include <nitrogl/samplers/gradients/gradient_lut.h>
 
 namespace nitrogl {
 
@@ -21,20 +22,53 @@ namespace nitrogl {
      * A Circular Gradient sampler.
      *
      * Notes:
-     * - Can hold up to 10 colors
+     * - Can hold up to N colors, the shader arrays are sized to N and the stops
+     *   loop has a fixed length of N
+     * - LUT mode bakes the stops into a 1D texture, see `gradient_lut`
      */
-    struct circular_gradient : public sampler_t {
+    template<unsigned N>
+    struct basic_circular_gradient : public sampler_t {
         const char * name() const override { return "line_gradient"; }
+        nitrogl::uintptr_type hash_code() const override {
+            // N sizes the shader arrays and loop, so it is part of the shader identity
+            microc::iterative_murmur<nitrogl::uintptr_type> murmur;
+            murmur.begin_cast(main());
+            murmur.next(N);
+            return murmur.end();
+        }
+
         const char * uniforms() const override {
-            return R"(
+            if(_lut_mode)
+                return R"(
+{
+    // center.xy, 1/radius, texel scale, texel bias
+    float inputs[5];
+    sampler2D lut;
+}
+)";
+            // specialized once per N, so the pointer is stable and unique per N
+            static const char uniforms_template[] = R"(
 {
-    float inputs[10*6+5];
+    float inputs[$N*6+5];
 }
 )";
+            static char source[sizeof(uniforms_template) + 64];
+            static const char * const specialized =
+                    nitrogl::specialize_int_into(source, sizeof(source), uniforms_template, "$N", N);
+            return specialized;
         }
 
         const char * main() const override {
-            return R"(
+            if(_lut_mode)
+                return R"(
+(in vec3 uv) {
+    vec2 c = vec2(data.inputs[0], data.inputs[1]);
+    float t = clamp(distance(uv.xy, c)*data.inputs[2], 0.0, 1.0);
+    return TEXTURE_2D(data.lut, vec2(t*data.inputs[3] + data.inputs[4], 0.5));
+}
+)";
+            // specialized once per N, so the pointer is stable and unique per N
+            static const char main_template[] = R"(
 (in vec3 uv) {
     //////////////
     // main input
@@ -52,7 +86,8 @@ namespace nitrogl {
     int pos = 0;
     float distance_to_center = distance(p, c);
     float distance_to_closest_stop = 0.0;
-    for (pos=0; pos<count; ++pos) {
+    for (pos=0; pos<$N; ++pos) {
+        if(pos>=count) break;
         int idx = IDX(pos);
         float dist_of_stop_to_center = data.inputs[idx+0];
         float d = distance_to_center - dist_of_stop_to_center;
@@ -79,6 +114,10 @@ namespace nitrogl {
     return final;
 }
 )";
+            static char source[sizeof(main_template) + 64];
+            static const char * const specialized =
+                    nitrogl::specialize_int_into(source, sizeof(source), main_template, "$N", N);
+            return specialized;
         }
 
     private:
@@ -98,8 +137,15 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
+            if(_lut_mode) {
+                float inputs[5] = { _center.x, _center.y, _radius>0.0f ? 1.0f/_radius : 0.0f,
+                                    gradient_lut::texel_scale(), gradient_lut::texel_bias() };
+                glUniform1fv(get_uniform_location(program, "inputs"), 5, inputs);
+                gradient_lut::use(_stops, _index, get_uniform_location(program, "lut"));
+                return;
+            }
             // minus the where float
-            float inputs[5 + 6*10];
+            float inputs[5 + 6*N];
             inputs[0] = float(_index);
             inputs[1] = float(window_size()); // window size
             inputs[2] = float(offset()); // window size
@@ -135,7 +181,7 @@ namespace nitrogl {
         }
 
         void updateStop(int index, float where, color_t color) {
-            if(index>_index) {
+            if(index>_index || index>=int(N)) {
 #ifndef NITROGL_DISABLE_THROW
                 struct out_of_range{};
                 throw out_of_range{};
@@ -143,6 +189,7 @@ namespace nitrogl {
                 return;
             }
 
+            invalidate_uniforms();
             auto & stop = _stops[index];
 
             stop.where = where;
@@ -160,20 +207,29 @@ namespace nitrogl {
         }
         int stops() const { return _index; }
 
-        void reset() { _index=0; }
+        void reset() { _index=0; invalidate_uniforms(); }
+
+        /**
+         * LUT mode bakes the stops ramp into a cached 1D texture
+         */
+        void setLUTMode(bool on) { _lut_mode=on; invalidate_uniforms(); }
+        bool isLUTMode() const { return _lut_mode; }
 
     private:
         vec2f _center;
         float _radius;
         int _index = 0;
-        stop_t _stops[10] {};
+        bool _lut_mode = false;
+        stop_t _stops[N] {};
 
     public:
-        explicit circular_gradient(const vec2f & center = vec2f(0.5f, 0.5f),
+        explicit basic_circular_gradient(const vec2f & center = vec2f(0.5f, 0.5f),
                       float radius = 0.5f) :
                       _center(center), _radius(radius) {
             setNewRadial(center, radius);
         };
 
     };
+
+    using circular_gradient = basic_circular_gradient<10>;
 }
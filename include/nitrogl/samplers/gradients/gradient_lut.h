@@ -0,0 +1,152 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/ogl/gl_texture.h>
+#include <nitrogl/color.h>
+#include <nitrogl/traits.h>
+#include <nitrogl/_internal/murmur.h>
+#include <nitrogl/_internal/lru_pool.h>
+
+namespace nitrogl {
+
+    /**
+     * Baked 1D lookup textures for multi-stop gradients.
+     * The stops ramp is rasterized on the CPU into a (width x 1) RGBA texture, so a gradient
+     * in LUT mode only computes its parameter t and then does a single texture fetch.
+     *
+     * Notes:
+     * - Textures are cached by a hash of the stops in an LRU pool, so gradients with the
+     *   same stops share a texture and identical ramps are never baked twice.
+     * - LUT textures are bound to a texture unit per draw (see `texture_units`), so many
+     *   gradients in one draw never share a unit, and units do not change shader hash codes.
+     * - Outside the stops range, the first/last colors are extended. Wrapping LUTs (angular
+     *   gradients) instead interpolate from the last stop back to the first across the ends,
+     *   so the ramp is periodic. They are sampled with t in [0..1] directly and repeat, so
+     *   linear filtering is seamless across t=0/1, see `wrap_texel_scale/bias`.
+     * - Requires a current OpenGL context, as textures are created on demand.
+     */
+    struct gradient_lut {
+        static constexpr int width = 256;
+        using lut_pool_t = microc::lru_pool<gradient_lut, 4, nitrogl::uintptr_type,
+                                            nitrogl::std_rebind_allocator<>>;
+
+        gl_texture texture;
+        bool baked;
+
+        gradient_lut() : texture(gl_texture::un_generated_dummy()), baked(false) {}
+
+        /**
+         * hash stops, that have `where` and `color` members. colors and positions are
+         * quantized to the precision of the texture, so very close ramps share a texture.
+         */
+        template<class stop_type>
+        static nitrogl::uintptr_type hash_of(const stop_type * stops, int count, bool wrap=false) {
+            microc::iterative_murmur<nitrogl::uintptr_type> murmur;
+            murmur.begin(nitrogl::uintptr_type(count));
+            murmur.next(nitrogl::uintptr_type(wrap));
+            for (int ix = 0; ix < count; ++ix) {
+                const auto & s = stops[ix];
+                murmur.next(quantize(s.where, 1<<16));
+                murmur.next((quantize(s.color.r, 255)<<24) | (quantize(s.color.g, 255)<<16) |
+                            (quantize(s.color.b, 255)<<8) | quantize(s.color.a, 255));
+            }
+            return murmur.end();
+        }
+
+        /**
+         * Get a LUT texture for stops, that have `where` and `color` members. The stops
+         * are expected to be sorted by `where` in [0..1]
+         * @param wrap interpolate from the last stop back to the first, periodic ramp
+         */
+        template<class stop_type>
+        static const gl_texture & get(const stop_type * stops, int count, bool wrap=false) {
+            static lut_pool_t pool{0.5f, nitrogl::std_rebind_allocator<>()};
+            if(!pool.are_items_constructed())
+                pool.construct();
+            auto res = pool.get(hash_of(stops, count, wrap));
+            auto & lut = res.object;
+            if(!res.is_active || !lut.baked) lut.bake(stops, count, wrap);
+            return lut.texture;
+        }
+
+        /**
+         * bind the LUT texture of the stops and upload its unit to a sampler2D uniform
+         */
+        template<class stop_type>
+        static void use(const stop_type * stops, int count, GLint location, bool wrap=false) {
+            glUniform1i(location, get(stops, count, wrap).use());
+        }
+
+        // maps t in [0..1] to the texel centers of the first and last texels
+        static constexpr float texel_scale() { return float(width-1)/float(width); }
+        static constexpr float texel_bias() { return 0.5f/float(width); }
+        // wrapping LUTs are sampled at t, texel ix holds t=(ix+0.5)/width
+        static constexpr float wrap_texel_scale() { return 1.0f; }
+        static constexpr float wrap_texel_bias() { return 0.0f; }
+
+    private:
+        static nitrogl::uintptr_type quantize(float v, unsigned scale) {
+            v = v<0.0f ? 0.0f : (v>1.0f ? 1.0f : v);
+            return nitrogl::uintptr_type(v*float(scale) + 0.5f);
+        }
+
+        static color_t mix(const color_t & l, const color_t & r, float f) {
+            color_t c;
+            c.r = l.r + (r.r-l.r)*f; c.g = l.g + (r.g-l.g)*f;
+            c.b = l.b + (r.b-l.b)*f; c.a = l.a + (r.a-l.a)*f;
+            return c;
+        }
+
+        template<class stop_type>
+        void bake(const stop_type * stops, int count, bool wrap) {
+            unsigned char pixels[width*4];
+            int pos = 0;
+            for (int ix = 0; ix < width; ++ix) {
+                const float t = wrap ? (float(ix)+0.5f)/float(width) : float(ix)/float(width-1);
+                // advance to the first stop, that is right of t
+                while(pos<count && stops[pos].where<=t) ++pos;
+                color_t c{};
+                if(count==0) {}
+                else if(wrap && (pos==0 || pos==count)) {
+                    // the segment from the last stop, through t=1 (=0), to the first stop
+                    const auto & l = stops[count-1];
+                    const auto & r = stops[0];
+                    const float len = 1.0f - l.where + r.where;
+                    const float d = pos==0 ? t + 1.0f - l.where : t - l.where;
+                    c = mix(l.color, r.color, len>0.0f ? d/len : 0.0f);
+                }
+                else if(pos==0) c = stops[0].color;
+                else if(pos==count) c = stops[count-1].color;
+                else {
+                    const auto & l = stops[pos-1];
+                    const auto & r = stops[pos];
+                    const float len = r.where-l.where;
+                    c = mix(l.color, r.color, len>0.0f ? (t-l.where)/len : 1.0f);
+                }
+                pixels[(ix<<2) + 0] = (unsigned char)quantize(c.r, 255);
+                pixels[(ix<<2) + 1] = (unsigned char)quantize(c.g, 255);
+                pixels[(ix<<2) + 2] = (unsigned char)quantize(c.b, 255);
+                pixels[(ix<<2) + 3] = (unsigned char)quantize(c.a, 255);
+            }
+            if(!baked) {
+                texture = gl_texture(width, 1, GL_RGBA, false);
+                baked = true;
+            }
+            // stops at both ends leave no wrap segment, a hard edge, that must not be filtered
+            const bool repeat = wrap && count && 1.0f - stops[count-1].where + stops[0].where > 0.0f;
+            const GLint wrap_s = repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+            texture.uploadImage(GL_RGBA, GL_UNSIGNED_BYTE, pixels, 1,
+                                GL_LINEAR, GL_LINEAR, wrap_s, GL_CLAMP_TO_EDGE);
+        }
+    };
+
+}
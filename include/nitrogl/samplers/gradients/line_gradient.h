@@ -16,6 +16,7 @@
 #include <nitrogl/traits.h>
 #include <nitrogl/functions/distance.h>
 #include <nitrogl/_internal/string_utils.h>
+#include <nitrogl/samplers/gradients/gradient_lut.h>
 
 namespace nitrogl {
 
@@ -23,21 +24,57 @@ namespace nitrogl {
      * A Gradient sampler.
      *
      * Notes:
-     * - Can hold up to 10 colors
+     * - Can hold up to N colors, the shader arrays are sized to N and the stops
+     *   loop has a fixed length of N, so a small N is cheaper per fragment
      * - You can also change rotation
+     * - LUT mode bakes the stops into a 1D texture, so the per-fragment stops
+     *   loop becomes a single texture fetch, see `gradient_lut`
      */
-    struct line_gradient : public sampler_t {
+    template<unsigned N>
+    struct basic_line_gradient : public sampler_t {
         const char * name() const override { return "line_gradient"; }
+        nitrogl::uintptr_type hash_code() const override {
+            // N sizes the shader arrays and loop, so it is part of the shader identity
+            microc::iterative_murmur<nitrogl::uintptr_type> murmur;
+            murmur.begin_cast(main());
+            murmur.next(N);
+            return murmur.end();
+        }
+
         const char * uniforms() const override {
-            return R"(
+            if(_lut_mode)
+                return R"(
+{
+    // start.xy, dir.xy/|dir|^2, texel scale, texel bias
+    float inputs[6];
+    sampler2D lut;
+}
+)";
+            // specialized once per N, so the pointer is stable and unique per N
+            static const char uniforms_template[] = R"(
 {
-    float inputs[10*8+3];
+    float inputs[$N*8+3];
 }
 )";
+            static char source[sizeof(uniforms_template) + 64];
+            static const char * const specialized =
+                    nitrogl::specialize_int_into(source, sizeof(source), uniforms_template, "$N", N);
+            return specialized;
         }
 
         const char * main() const override {
-            return R"(
+            if(_lut_mode)
+                return R"(
+(in vec3 uv) {
+    // t is the projection of p on the gradient line
+    vec2 start = vec2(data.inputs[0], data.inputs[1]);
+    vec2 dir = vec2(data.inputs[2], data.inputs[3]);
+    float t = clamp(dot(uv.xy - start, dir), 0.0, 1.0);
+    return TEXTURE_2D(data.lut, vec2(t*data.inputs[4] + data.inputs[5], 0.5));
+}
+)";
+            // specialized once per N, so the pointer is stable and unique per N
+            static const char main_template[] = R"(
 (in vec3 uv) {
     //////////////
     // main input
@@ -53,7 +90,8 @@ namespace nitrogl {
     //
     int pos = 0;
     float distance = 0.0;
-    for (pos=0; pos<count; ++pos) {
+    for (pos=0; pos<$N; ++pos) {
+        if(pos>=count) break;
         int idx = IDX(pos);
         // a*x + b*y + c
         float d = data.inputs[idx+0]*p.x + data.inputs[idx+1]*p.y + data.inputs[idx+2];
@@ -80,6 +118,10 @@ namespace nitrogl {
 //    return vec4(p.y,p.y,p.y,1.0);
 }
 )";
+            static char source[sizeof(main_template) + 64];
+            static const char * const specialized =
+                    nitrogl::specialize_int_into(source, sizeof(source), main_template, "$N", N);
+            return specialized;
         }
 
     private:
@@ -100,8 +142,18 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
+            if(_lut_mode) {
+                const auto dir = _end-_start;
+                const float dd = dir.dot(dir);
+                const float dd_inv = dd>0.0f ? 1.0f/dd : 0.0f;
+                float inputs[6] = { _start.x, _start.y, dir.x*dd_inv, dir.y*dd_inv,
+                                    gradient_lut::texel_scale(), gradient_lut::texel_bias() };
+                glUniform1fv(get_uniform_location(program, "inputs"), 6, inputs);
+                gradient_lut::use(_stops, _index, get_uniform_location(program, "lut"));
+                return;
+            }
             // minus the where float
-            float inputs[3 + 8*10];
+            float inputs[3 + 8*N];
             inputs[0] = _index;
             inputs[1] = window_size(); // window size
             inputs[2] = offset(); // window size
@@ -146,7 +198,7 @@ namespace nitrogl {
         }
 
         void updateStop(int index, float where, color_t color) {
-            if(index>_index) {
+            if(index>_index || index>=int(N)) {
 #ifndef NITROGL_DISABLE_THROW
                 struct out_of_range{};
                 throw out_of_range{};
@@ -156,6 +208,7 @@ namespace nitrogl {
 
             const auto dir = _end-_start;
             const auto p_w = _start + (_end-_start) * where;
+            invalidate_uniforms();
             auto & stop = _stops[index];
 
             stop.updateLine(p_w, dir);
@@ -195,19 +248,28 @@ namespace nitrogl {
             setNewLine(a_new, b_new);
         }
 
-        void reset() { _index=0; }
+        void reset() { _index=0; invalidate_uniforms(); }
+
+        /**
+         * LUT mode bakes the stops ramp into a cached 1D texture
+         */
+        void setLUTMode(bool on) { _lut_mode=on; invalidate_uniforms(); }
+        bool isLUTMode() const { return _lut_mode; }
 
     private:
         vec2f _start, _end;
         int _index = 0;
-        stop_t _stops[10] {};
+        bool _lut_mode = false;
+        stop_t _stops[N] {};
 
     public:
-        explicit line_gradient(const vec2f & start = vec2f(0.0f, 0.5f),
+        explicit basic_line_gradient(const vec2f & start = vec2f(0.0f, 0.5f),
                       const vec2f & end = vec2f(1.0f, 0.5f)) :
                     _start(start), _end(end) {
             setNewLine(start, end);
         };
 
     };
+
+    using line_gradient = basic_line_gradient<10>;
 }
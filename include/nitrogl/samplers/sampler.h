@@ -34,8 +34,11 @@ namespace nitrogl {
         struct no_more_than_99_samplers_allowed {};
         struct location_of_uniform_not_found {};
         unsigned int _sub_samplers_count;
+        unsigned int _uniforms_version;
+        bool _mergeable;
 
-        sampler_t() : _sub_samplers_count(0), _traversal_info{-1, false},
+        sampler_t() : _sub_samplers_count(0), _uniforms_version(0), _mergeable(false),
+                        _traversal_info{-1, false},
                         intrinsic_width(0.0f), intrinsic_height(0.0f) {
         }
 
@@ -91,6 +94,24 @@ namespace nitrogl {
                 sub_sampler(ix)->upload_uniforms(program);
             on_upload_uniforms_request(program);
         };
+        /**
+         * the rate of change of the normalized uv coordinates per canvas pixel of a draw
+         */
+        void update_uv_derivatives(float du_dx, float dv_dx, float du_dy, float dv_dy) {
+            const auto ssc = sub_samplers_count();
+            for (unsigned ix = 0; ix < ssc; ++ix)
+                sub_sampler(ix)->update_uv_derivatives(du_dx, dv_dx, du_dy, dv_dy);
+            on_uv_derivatives_update(du_dx, dv_dx, du_dy, dv_dy);
+        };
+        /**
+         * if this sampler or any of it's sub-samplers reads the uvs derivatives
+         */
+        bool uses_uv_derivatives() const {
+            const auto ssc = sub_samplers_count();
+            for (unsigned ix = 0; ix < ssc; ++ix)
+                if(sub_sampler(ix)->uses_uv_derivatives()) return true;
+            return on_uses_uv_derivatives();
+        }
 
         virtual nitrogl::uintptr_type hash_code() const {
             microc::iterative_murmur<nitrogl::uintptr_type> murmur;
@@ -101,10 +122,39 @@ namespace nitrogl {
             return murmur.end();
         }
 
+        /**
+         * A version of the uniforms of this sampler and it's sub-samplers, that changes
+         * whenever `invalidate_uniforms()` is called on any of them. Setters (gradients stops,
+         * regions, points, modes) invalidate their samplers, public uniform fields, that are
+         * assigned directly, require a call to `invalidate_uniforms()`.
+         * The hash code describes the shader, the uniforms version describes the values.
+         */
+        nitrogl::uintptr_type uniforms_version() const {
+            microc::iterative_murmur<nitrogl::uintptr_type> murmur;
+            murmur.begin(nitrogl::uintptr_type(_uniforms_version));
+            const auto ssc = sub_samplers_count();
+            for (unsigned int ix = 0; ix < ssc; ++ix)
+                murmur.next(sub_sampler(ix)->uniforms_version());
+            return murmur.end();
+        }
+        void invalidate_uniforms() { ++_uniforms_version; }
+
+        /**
+         * Opt in to the merged draws of the canvas pre-transform mode, see
+         * `canvas::updatePreTransformThreshold`. Merged draws are deferred, so a mergeable
+         * sampler (and it's sub-samplers) must stay alive until the canvas flushes, and
+         * changes of it's uniforms require `invalidate_uniforms()`. Off by default, so
+         * temporary samplers are always drawn right away.
+         */
+        void set_mergeable(bool on) { _mergeable = on; }
+        bool mergeable() const { return _mergeable; }
+
         virtual sampler_t * const * sub_samplers() const { return nullptr; }
         virtual sampler_t ** sub_samplers() { return nullptr; }
         virtual void on_cache_uniforms_locations(GLuint program) {};
         virtual void on_upload_uniforms_request(GLuint program) {}
+        virtual void on_uv_derivatives_update(float, float, float, float) {}
+        virtual bool on_uses_uv_derivatives() const { return false; }
         virtual unsigned int generate_traversal(unsigned int id) {
             _traversal_info.id=id;
             _traversal_info.visited=false;
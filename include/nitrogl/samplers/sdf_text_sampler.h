@@ -0,0 +1,99 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/samplers/sampler.h>
+#include <nitrogl/ogl/gl_texture.h>
+#include <nitrogl/channels.h>
+#include <nitrogl/color.h>
+
+namespace nitrogl {
+
+    /**
+     * Samples glyphs from a signed distance field atlas (see `text::sdf_font`).
+     * Coverage is a smoothstep of the distance around the outline, one screen pixel wide,
+     * so text stays sharp at any scale. `screen_px_range` is the distance range of the
+     * atlas in screen pixels, i.e. distance_range x (screen size / atlas size), the canvas
+     * updates it for every draw, because it knows the glyph scale and the transform.
+     */
+    struct sdf_text_sampler : public sampler_t {
+        const char * name() const override { return "sdf_text_sampler"; }
+        const char * uniforms() const override {
+            return R"(
+{
+    sampler2D texture;
+    vec4 color;
+    vec4 channel;
+    float channel_bias;
+    float screen_px_range;
+}
+)";
+        }
+
+        const char * main() const override {
+            if(multi_channel)
+                return R"(
+(in vec3 uv) {
+    vec4 t = TEXTURE_2D(data.texture, uv.xy);
+    float d = max(min(t.r, t.g), min(max(t.r, t.g), t.b));
+    float w = 0.5/max(data.screen_px_range, 1.0);
+    return vec4(data.color.rgb, data.color.a*smoothstep(0.5-w, 0.5+w, d));
+}
+)";
+            else
+                return R"(
+(in vec3 uv) {
+    float d = dot(TEXTURE_2D(data.texture, uv.xy), data.channel) + data.channel_bias;
+    float w = 0.5/max(data.screen_px_range, 1.0);
+    return vec4(data.color.rgb, data.color.a*smoothstep(0.5-w, 0.5+w, d));
+}
+)";
+        }
+
+        void on_cache_uniforms_locations(GLuint program) override {
+        }
+
+        void on_upload_uniforms_request(GLuint program) override {
+            texture.createMipMapsIfDirty();
+            glUniform1i(get_uniform_location(program, "texture"), texture.use());
+            glUniform4f(get_uniform_location(program, "color"), color.r, color.g, color.b, color.a);
+            glUniform1f(get_uniform_location(program, "screen_px_range"), screen_px_range);
+            if(!multi_channel) {
+                // d = dot(texel, mask) + bias, inverted channels are 1-d
+                const int c = int(channel);
+                const bool inverted = c>=4;
+                float m[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                m[c%4] = inverted ? -1.0f : 1.0f;
+                glUniform4f(get_uniform_location(program, "channel"), m[0], m[1], m[2], m[3]);
+                glUniform1f(get_uniform_location(program, "channel_bias"), inverted ? 1.0f : 0.0f);
+            }
+        }
+
+        gl_texture texture;
+        color_t color;
+        channels::channel channel;
+        float screen_px_range;
+        bool multi_channel;
+
+        /**
+         * @param atlas the distance field atlas (a non-owning copy is kept)
+         * @param color text color
+         * @param multi_channel msdf or sdf atlas
+         * @param channel the channel of a single-channel atlas
+         * @param screen_px_range the distance range in screen pixels
+         */
+        sdf_text_sampler(const gl_texture & atlas, const color_t & color, bool multi_channel=true,
+                         channels::channel channel=channels::channel::red_channel,
+                         float screen_px_range=4.0f) :
+                texture(atlas), color(color), channel(channel), screen_px_range(screen_px_range),
+                multi_channel(multi_channel), sampler_t() {}
+    };
+}
@@ -0,0 +1,80 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/samplers/sampler.h>
+#include <nitrogl/ogl/gl_texture_array.h>
+
+namespace nitrogl {
+
+    /**
+     * Samples a layer of a texture array (GL_TEXTURE_2D_ARRAY).
+     * Unlike `texture_sampler`, the layer is a plain uniform and not part of the hash code,
+     * so all the images packed into the same texture array share a single shader program.
+     * Use `texture_array_allocator` to pack same-sized images into layers.
+     * Requires gl >= 3.0 or gl-es >= 3.0.
+     */
+    struct texture_array_sampler : public sampler_t {
+        const char * name() const override { return "texture_array_sampler"; }
+        const char * uniforms() const override {
+            return R"(
+{
+    sampler2DArray texture;
+    float layer;
+}
+)";
+        }
+
+        const char * main() const override {
+            if(texture.is_premul_alpha())
+                return R"(
+(in vec3 uv) {
+    vec4 tex = TEXTURE_2D_ARRAY(data.texture, vec3(uv.xy, data.layer));
+    if(tex.a>0.0) tex.rgb/=tex.a;
+    return clamp(tex, 0.0, 1.0);
+}
+)";
+            else
+                return R"(
+(in vec3 uv) {
+    return TEXTURE_2D_ARRAY(data.texture, vec3(uv.xy, data.layer));
+}
+)";
+        }
+
+        void on_cache_uniforms_locations(GLuint program) override {
+        }
+
+        void on_upload_uniforms_request(GLuint program) override {
+            glUniform1i(get_uniform_location(program, "texture"), texture.use());
+            glUniform1f(get_uniform_location(program, "layer"), float(layer));
+        }
+
+        void update_intrinsic(bool on) {
+            intrinsic_width = on ? float(texture.width()) : -1.0f;
+            intrinsic_height = on ? float(texture.height()) : -1.0f;
+        }
+
+        gl_texture_array texture;
+        GLint layer;
+
+        /**
+         * @param texture the texture array (a non-owning copy is kept)
+         * @param layer the layer to sample
+         * @param intrinsic use the dimensions of the layers as intrinsic size
+         */
+        explicit texture_array_sampler(const gl_texture_array & texture, GLint layer=0,
+                                       bool intrinsic=false) :
+                texture(texture), layer(layer), sampler_t() {
+            update_intrinsic(intrinsic);
+        }
+    };
+}
@@ -0,0 +1,88 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/samplers/sampler.h>
+#include <nitrogl/ogl/gl_texture.h>
+
+namespace nitrogl {
+
+    /**
+     * Samples a sub-rectangle [u0,v0]x[u1,v1] of a texture, for example an image
+     * inside a `texture_atlas`. The region is a plain uniform and is not part of
+     * the hash code, so all the regions of one texture share a single shader program.
+     */
+    struct texture_region_sampler : public sampler_t {
+        const char * name() const override { return "texture_region_sampler"; }
+        const char * uniforms() const override {
+            return R"(
+{
+    sampler2D texture;
+    vec4 region;
+}
+)";
+        }
+
+        const char * main() const override {
+            if(texture.is_premul_alpha())
+                return R"(
+(in vec3 uv) {
+    vec4 tex = TEXTURE_2D(data.texture, mix(data.region.xy, data.region.zw, uv.xy));
+    if(tex.a>0.0) tex.rgb/=tex.a;
+    return clamp(tex, 0.0, 1.0);
+}
+)";
+            else
+                return R"(
+(in vec3 uv) {
+    return TEXTURE_2D(data.texture, mix(data.region.xy, data.region.zw, uv.xy));
+}
+)";
+        }
+
+        void on_cache_uniforms_locations(GLuint program) override {
+        }
+
+        void on_upload_uniforms_request(GLuint program) override {
+            texture.createMipMapsIfDirty();
+            glUniform1i(get_uniform_location(program, "texture"), texture.use());
+            glUniform4f(get_uniform_location(program, "region"), u0, v0, u1, v1);
+        }
+
+        void update_region(float $u0, float $v0, float $u1, float $v1) {
+            u0=$u0; v0=$v0; u1=$u1; v1=$v1;
+            invalidate_uniforms();
+        }
+
+        void update_intrinsic(bool on) {
+            const float dw = u1-u0, dh = v1-v0;
+            intrinsic_width = on ? float(texture.width())*(dw<0?-dw:dw) : -1.0f;
+            intrinsic_height = on ? float(texture.height())*(dh<0?-dh:dh) : -1.0f;
+        }
+
+        gl_texture texture;
+        float u0, v0, u1, v1;
+
+        /**
+         * @param texture the texture (a non-owning copy is kept)
+         * @param u0,v0 normalized top-left of the region
+         * @param u1,v1 normalized bottom-right of the region
+         * @param intrinsic use the dimensions of the region as intrinsic size
+         */
+        explicit texture_region_sampler(const gl_texture & texture,
+                                        float u0=0.0f, float v0=0.0f,
+                                        float u1=1.0f, float v1=1.0f,
+                                        bool intrinsic=false) :
+                texture(texture), u0(u0), v0(v0), u1(u1), v1(v1), sampler_t() {
+            update_intrinsic(intrinsic);
+        }
+    };
+}
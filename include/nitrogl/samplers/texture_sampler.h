@@ -13,38 +13,60 @@
 #include <nitrogl/samplers/sampler.h>
 #include <nitrogl/traits.h>
 #include <nitrogl/ogl/gl_texture.h>
+#include <nitrogl/math.h>
 
 namespace nitrogl {
 
+    /**
+     * Samples a texture.
+     * - Stale mip-maps (after uploads) are generated right before sampling.
+     * - In LOD mode (see `setLODMode`), the canvas computes the mip level from the draw
+     *   transform and the sampler samples it with `textureLod`. This is good for axis-aligned
+     *   2D draws of heavily down-scaled images (thumbnails), that then sample a small mip
+     *   without relying on the derivatives of the fragment shader. Requires glsl >= 130,
+     *   otherwise the lod is ignored.
+     */
     struct texture_sampler : public sampler_t {
         const char * name() const override { return "texture_sampler"; }
         const char * uniforms() const override {
             return R"(
 {
     sampler2D texture;
+    float lod;
 }
 )";
         }
 
         nitrogl::uintptr_type hash_code() const override {
-            // on some opengl hardware, when the slot uniform changes,
-            // the driver patches or recompiles the shader because texture is
-            // a non-opaque data type. Therefore, slot MUST change the hash code
-            // of the sampler. Therefore, EVERY UNIQUE SLOT HAS TO GENERATE A UNIQUE SHADER !!!
-            // Otherwise, performance will be very bad if user uses the same shader with dynamic
-            // slot uniform, this will cause patching --> very bad performance
+            // the texture unit is not part of the shader. Units are assigned per draw, and
+            // a texture keeps the unit it is bound to, so the sampler uniform rarely changes.
             microc::iterative_murmur<nitrogl::uintptr_type> murmur;
             murmur.begin_cast(main());
-            murmur.next(texture.slot());
             return murmur.end();
         }
 
         const char * main() const override {
+            if(_lod_mode) {
+                if(texture.is_premul_alpha())
+                    return R"(
+(in vec3 uv) {
+    vec4 tex = TEXTURE_2D_LOD(data.texture, uv.xy, data.lod);
+    if(tex.a>0.0) tex.rgb/=tex.a;
+    return clamp(tex, 0.0, 1.0);
+}
+)";
+                else
+                    return R"(
+(in vec3 uv) {
+    return TEXTURE_2D_LOD(data.texture, uv.xy, data.lod);
+}
+)";
+            }
             if(texture.is_premul_alpha())
                 return R"(
 (in vec3 uv) {
     vec4 tex = TEXTURE_2D(data.texture, uv.xy);
-    tex.rgb/=tex.a;
+    if(tex.a>0.0) tex.rgb/=tex.a;
     return clamp(tex, 0.0, 1.0);
 }
 )";
@@ -60,24 +82,53 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
-            texture.use(texture.slot());
-            glUniform1i(get_uniform_location(program, "texture"), texture.slot());
+            texture.createMipMapsIfDirty();
+            glUniform1i(get_uniform_location(program, "texture"), texture.use());
+            if(_lod_mode)
+                glUniform1f(get_uniform_location(program, "lod"), lod);
         }
 
+        bool on_uses_uv_derivatives() const override { return _lod_mode; }
+
+        void on_uv_derivatives_update(float du_dx, float dv_dx, float du_dy, float dv_dy) override {
+            if(!_lod_mode) return;
+            // the footprint of a canvas pixel in texels, same as the gl spec, but on the cpu
+            const float w = float(texture.width()), h = float(texture.height());
+            const float x = (du_dx*du_dx*w*w + dv_dx*dv_dx*h*h);
+            const float y = (du_dy*du_dy*w*w + dv_dy*dv_dy*h*h);
+            const float max_lod = float(texture.levels() - 1);
+            // lod = log2(sqrt(rho^2)) = log2(rho^2)/2
+            lod = 0.5f * nitrogl::math::log2(x<y ? y : x);
+            lod = lod<0.0f ? 0.0f : (lod>max_lod ? max_lod : lod);
+        }
+
+        /**
+         * In LOD mode, the mip level is computed by the canvas for every draw, or set
+         * manually into `lod`. This changes the shader of the sampler.
+         */
+        void setLODMode(bool on) { _lod_mode = on; invalidate_uniforms(); }
+        bool isLODMode() const { return _lod_mode; }
+
         void update_intrinsic(bool on) {
             intrinsic_width = on ? float(texture.width()) : -1.0f;
             intrinsic_height = on ? float(texture.height()) : -1.0f;
         }
 
+    private:
+        bool _lod_mode;
+
+    public:
         gl_texture texture;
+        float lod;
+
         explicit texture_sampler(const gl_texture & texture,
-                                 bool intrinsic=false) :
-                texture(texture), sampler_t() {
+                                 bool intrinsic=false, bool lod_mode=false) :
+                _lod_mode(lod_mode), texture(texture), lod(0.0f), sampler_t() {
             update_intrinsic(intrinsic);
         }
         explicit texture_sampler(gl_texture && texture,
-                                 bool intrinsic=false) :
-                texture(nitrogl::traits::move(texture)), sampler_t() {
+                                 bool intrinsic=false, bool lod_mode=false) :
+                _lod_mode(lod_mode), texture(nitrogl::traits::move(texture)), lod(0.0f), sampler_t() {
             update_intrinsic(intrinsic);
         }
     };
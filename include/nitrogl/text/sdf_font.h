@@ -0,0 +1,46 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "bitmap_font.h"
+#include "../channels.h"
+
+namespace nitrogl {
+    namespace text {
+
+        /**
+         * signed distance field font. The glyphs atlas holds distances to the glyph outlines
+         * instead of coverage, so a single atlas serves all sizes and transforms, see
+         * `sdf_text_sampler`. Metrics and layout are the same as `bitmap_font` (BMFont), which
+         * is what most distance field generators (msdf-atlas-gen, msdf-bmfont) output.
+         * - multi-channel (msdf) atlases keep sharp corners, the distance is the median of rgb
+         * - single-channel (sdf) atlases keep the distance in a single channel
+         * - the atlas should be loaded without pre-multiplied alpha and with linear filtering
+         * @tparam MAX_CHARS max number of glyphs
+         */
+        template<unsigned MAX_CHARS=128>
+        class sdf_font : public bitmap_font<MAX_CHARS> {
+            using base = bitmap_font<MAX_CHARS>;
+        public:
+            /** The range of the distance field in atlas pixels, from the outline
+              * to the edge of the field (msdf-atlas-gen "pxrange", msdf-bmfont "distanceRange"). */
+            float distanceRange=4.0f;
+            /** Is it a multi-channel (msdf) distance field ? */
+            bool multiChannel=true;
+            /** The channel of a single-channel distance field. */
+            channels::channel channel=channels::channel::red_channel;
+
+        public:
+            explicit sdf_font(const gl_texture & atlas) : base(atlas) {}
+            explicit sdf_font(gl_texture && atlas) : base(nitrogl::traits::move(atlas)) {}
+        };
+    }
+}
@@ -31,6 +31,18 @@ namespace nitrogl {
             POINTS=GL_POINTS
         };
 
+        /**
+         * the open-gl type of an index type, GL_UNSIGNED_INT/SHORT/BYTE
+         */
+        template<class index_type> struct gl_index_type;
+        template<> struct gl_index_type<GLuint> { static constexpr GLenum value = GL_UNSIGNED_INT; };
+        template<> struct gl_index_type<GLushort> { static constexpr GLenum value = GL_UNSIGNED_SHORT; };
+        template<> struct gl_index_type<GLubyte> { static constexpr GLenum value = GL_UNSIGNED_BYTE; };
+
+        inline GLsizeiptr gl_index_size(GLenum type) {
+            return type==GL_UNSIGNED_BYTE ? 1 : (type==GL_UNSIGNED_SHORT ? 2 : 4);
+        }
+
         inline indices microtess_indices_type_to_nitrogl(microtess::triangles::indices type) {
             switch (type) {
                 case microtess::triangles::indices::TRIANGLES_WITH_BOUNDARY:
@@ -106,22 +118,22 @@ namespace nitrogl {
          * @param size_indices (Optional) size of indices (if not null), or vertices (if indices are null)
          * @return bounding box rectangle
          */
+        template<class index_type>
         rectf triangles_bbox(const vec2f *vertices,
                              const index size_vertices,
-                            const index *indices,
+                            const index_type *indices,
                             const index size_indices) {
             const bool has_indices = indices!=nullptr && size_indices!=0;
-            const auto & ref_base = has_indices ? vertices[indices[0]] : vertices[0];
-            rectf rect{ ref_base.x, ref_base.y, ref_base.x, ref_base.y };
-            const auto size = has_indices ? size_indices : size_vertices;
-            for (unsigned ix = 0; ix < size; ++ix) { // compute bounding box
-                const auto & pt = has_indices ? vertices[indices[ix]] : vertices[ix];
-                rect.left = functions::min(rect.left, pt.x);
-                rect.top = functions::min(rect.top, pt.y);
-                rect.right = functions::max(rect.right, pt.x);
-                rect.bottom = functions::max(rect.bottom, pt.y);
-            }
-            return rect;
+            // simd kernels, see vec2_kernels
+            return has_indices ? vec2_kernels::bbox(vertices, indices, size_indices) :
+                                 vec2_kernels::bbox(vertices, size_vertices);
+        }
+
+        inline rectf triangles_bbox(const vec2f *vertices,
+                                    const index size_vertices,
+                                    const index *indices,
+                                    const index size_indices) {
+            return triangles_bbox<index>(vertices, size_vertices, indices, size_indices);
         }
 
         /**